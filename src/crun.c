@@ -33,6 +33,7 @@
 #include "libcrun/utils.h"
 #include "libcrun/custom-handler.h"
 #include "libcrun/status.h"
+#include "libcrun/trace.h"
 
 /* Commands.  */
 #include "run.h"
@@ -52,6 +53,9 @@
 #include "checkpoint.h"
 #include "mounts.h"
 #include "restore.h"
+#include "serve.h"
+#include "events.h"
+#include "seccomp_compile.h"
 
 static struct crun_global_arguments arguments;
 
@@ -119,6 +123,16 @@ init_libcrun_context (libcrun_context_t *con, const char *id, struct crun_global
         return ret;
     }
 
+  if (glob->status_format)
+    {
+      ret = libcrun_set_status_format (glob->status_format, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+    }
+
+  if (glob->trace)
+    libcrun_trace_set_file (glob->trace);
+
   libcrun_set_verbosity (glob->verbosity);
   libcrun_debug ("Using debug verbosity");
 
@@ -149,10 +163,14 @@ enum
   COMMAND_CHECKPOINT,
   COMMAND_RESTORE,
   COMMAND_MOUNTS,
+  COMMAND_SERVE,
+  COMMAND_EVENTS,
+  COMMAND_SECCOMP_COMPILE,
 };
 
 struct commands_s commands[] = { { COMMAND_CREATE, "create", crun_command_create },
                                  { COMMAND_DELETE, "delete", crun_command_delete },
+                                 { COMMAND_EVENTS, "events", crun_command_events },
                                  { COMMAND_EXEC, "exec", crun_command_exec },
                                  { COMMAND_LIST, "list", crun_command_list },
                                  { COMMAND_KILL, "kill", crun_command_kill },
@@ -170,6 +188,8 @@ struct commands_s commands[] = { { COMMAND_CREATE, "create", crun_command_create
                                  { COMMAND_RESTORE, "restore", crun_command_restore },
 #endif
                                  { COMMAND_MOUNTS, "mounts", crun_command_mounts },
+                                 { COMMAND_SECCOMP_COMPILE, "seccomp-compile", crun_command_seccomp_compile },
+                                 { COMMAND_SERVE, "serve", crun_command_serve },
                                  {
                                      0,
                                  } };
@@ -180,6 +200,7 @@ static char doc[] = "\nCOMMANDS:\n"
 #endif
                     "\tcreate      - create a container\n"
                     "\tdelete      - remove definition for a container\n"
+                    "\tevents      - display the container events and resource usage\n"
                     "\texec        - exec a command in a running container\n"
                     "\tfeatures    - show the enabled features\n"
                     "\tlist        - list known containers\n"
@@ -190,6 +211,8 @@ static char doc[] = "\nCOMMANDS:\n"
                     "\trestore     - restore a container\n"
 #endif
                     "\trun         - run a container\n"
+                    "\tseccomp-compile - store a seccomp profile in the cache\n"
+                    "\tserve       - serve requests on a UNIX socket\n"
                     "\tspec        - generate a configuration file\n"
                     "\tstart       - start a container\n"
                     "\tstate       - output the state of a container\n"
@@ -220,7 +243,9 @@ enum
   OPTION_LOG_FORMAT,
   OPTION_LOG_LEVEL,
   OPTION_ROOT,
-  OPTION_ROOTLESS
+  OPTION_ROOTLESS,
+  OPTION_STATUS_FORMAT,
+  OPTION_TRACE
 };
 
 const char *argp_program_bug_address = "https://github.com/containers/crun/issues";
@@ -233,6 +258,8 @@ static struct argp_option options[] = { { "debug", OPTION_DEBUG, 0, 0, "produce
                                         { "log-level", OPTION_LOG_LEVEL, "LEVEL", 0, "log level to use: 'error' (default), 'warning' or 'debug'", 0 },
                                         { "root", OPTION_ROOT, "DIR", 0, NULL, 0 },
                                         { "rootless", OPTION_ROOTLESS, "VALUE", 0, NULL, 0 },
+                                        { "status-format", OPTION_STATUS_FORMAT, "FORMAT", 0, "format of the container status file: 'json' (default) or 'binary'", 0 },
+                                        { "trace", OPTION_TRACE, "FILE", 0, "write the timing of the container creation phases to FILE", 0 },
                                         { "version", OPTION_VERSION, 0, 0, NULL, 0 },
                                         // alias OPTION_VERSION_CAP with OPTION_VERSION
                                         { NULL, OPTION_VERSION_CAP, 0, OPTION_ALIAS, NULL, 0 },
@@ -352,6 +379,14 @@ parse_opt (int key, char *arg, struct argp_state *state)
       arguments.root = argp_mandatory_argument (arg, state);
       break;
 
+    case OPTION_STATUS_FORMAT:
+      arguments.status_format = argp_mandatory_argument (arg, state);
+      break;
+
+    case OPTION_TRACE:
+      arguments.trace = argp_mandatory_argument (arg, state);
+      break;
+
     case OPTION_ROOTLESS:
       /* Ignored.  So that a runc command line won't fail.  */
       break;
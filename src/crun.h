@@ -25,6 +25,8 @@ struct crun_global_arguments
   char *root;
   char *log;
   char *log_format;
+  char *status_format;
+  char *trace;
   const char *handler;
 
   int argc;
@@ -0,0 +1,100 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <argp.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "crun.h"
+#include "libcrun/container.h"
+#include "libcrun/utils.h"
+
+static char doc[] = "OCI runtime";
+
+enum
+{
+  OPTION_STATS = 1000,
+  OPTION_INTERVAL,
+};
+
+struct events_options_s
+{
+  bool stats;
+  int interval;
+};
+
+static struct events_options_s events_options;
+
+static struct argp_option options[]
+    = { { "stats", OPTION_STATS, 0, 0, "print the stats once and exit", 0 },
+        { "interval", OPTION_INTERVAL, "SECONDS", 0, "interval between the stats samples (default 5)", 0 },
+        {
+            0,
+        } };
+
+static char args_doc[] = "events CONTAINER";
+
+static error_t
+parse_opt (int key, char *arg, struct argp_state *state)
+{
+  switch (key)
+    {
+    case OPTION_STATS:
+      events_options.stats = true;
+      break;
+
+    case OPTION_INTERVAL:
+      events_options.interval = parse_int_or_fail (argp_mandatory_argument (arg, state), "interval");
+      if (events_options.interval <= 0)
+        error (EXIT_FAILURE, 0, "invalid interval `%s`", arg);
+      break;
+
+    default:
+      return ARGP_ERR_UNKNOWN;
+    }
+
+  return 0;
+}
+
+static struct argp run_argp = { options, parse_opt, args_doc, doc, NULL, NULL, NULL };
+
+int
+crun_command_events (struct crun_global_arguments *global_args, int argc, char **argv, libcrun_error_t *err)
+{
+  int first_arg;
+  int ret;
+  libcrun_context_t crun_context = {
+    0,
+  };
+
+  events_options.interval = 5;
+
+  argp_parse (&run_argp, argc, argv, ARGP_IN_ORDER, &first_arg, &events_options);
+  crun_assert_n_args (argc - first_arg, 1, 1);
+
+  ret = init_libcrun_context (&crun_context, argv[first_arg], global_args, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  return libcrun_container_events (&crun_context, argv[first_arg], events_options.stats, events_options.interval,
+                                   stdout, err);
+}
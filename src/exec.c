@@ -39,6 +39,7 @@ struct exec_options_s
   bool no_new_privs;
   int preserve_fds;
   const char *process;
+  const char *batch;
   const char *console_socket;
   const char *pid_file;
   char *process_label;
@@ -62,6 +63,7 @@ enum
   OPTION_PROCESS_LABEL,
   OPTION_APPARMOR,
   OPTION_CGROUP,
+  OPTION_BATCH,
 };
 
 static struct exec_options_s exec_options;
@@ -71,6 +73,7 @@ static struct argp_option options[]
           "path to a socket that will receive the ptmx end of the tty", 0 },
         { "tty", 't', "TTY", OPTION_ARG_OPTIONAL, "allocate a pseudo-TTY", 0 },
         { "process", 'p', "FILE", 0, "path to the process.json", 0 },
+        { "batch", OPTION_BATCH, "FILE", 0, "path to a JSON array of processes to run", 0 },
         { "cwd", OPTION_CWD, "CWD", 0, "current working directory", 0 },
         { "cgroup", OPTION_CGROUP, "PATH", 0, "sub-cgroup in the container", 0 },
         { "detach", 'd', 0, 0, "detach the command in the background", 0 },
@@ -167,6 +170,10 @@ parse_opt (int key, char *arg, struct argp_state *state)
       exec_options.process = arg;
       break;
 
+    case OPTION_BATCH:
+      exec_options.batch = argp_mandatory_argument (arg, state);
+      break;
+
     case 't':
       exec_options.tty = arg == NULL || (strcmp (arg, "false") != 0 && strcmp (arg, "no") != 0);
       break;
@@ -266,7 +273,10 @@ crun_command_exec (struct crun_global_arguments *global_args, int argc, char **a
   crun_context.listen_fds = 0;
 
   argp_parse (&run_argp, argc, argv, ARGP_IN_ORDER, &first_arg, &exec_options);
-  crun_assert_n_args (argc - first_arg, exec_options.process ? 1 : 2, -1);
+  crun_assert_n_args (argc - first_arg, (exec_options.process || exec_options.batch) ? 1 : 2, -1);
+
+  if (exec_options.process && exec_options.batch)
+    libcrun_fail_with_error (0, "cannot specify both --process and --batch");
 
   ret = init_libcrun_context (&crun_context, argv[first_arg], global_args, err);
   if (UNLIKELY (ret < 0))
@@ -283,6 +293,9 @@ crun_command_exec (struct crun_global_arguments *global_args, int argc, char **a
       crun_context.preserve_fds += crun_context.listen_fds;
     }
 
+  if (exec_options.batch)
+    return libcrun_container_exec_batch_file (&crun_context, argv[first_arg], exec_options.batch, err);
+
   if (exec_options.process)
     exec_opts.path = exec_options.process;
   else
@@ -0,0 +1,200 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2025 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <config.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "annotations.h"
+#include "utils.h"
+
+#define RUN_OCI_PREFIX "run.oci."
+
+enum
+{
+  TYPE_STRING,
+  TYPE_BOOL,
+  TYPE_NUMBER,
+};
+
+struct run_oci_annotation_def_s
+{
+  /* Name without the run.oci. prefix.  */
+  const char *name;
+  int type;
+  long long min;
+  long long max;
+};
+
+/* Sorted by name, in the same order as enum run_oci_annotation_e.  */
+static const struct run_oci_annotation_def_s known_annotations[] = {
+  [RUN_OCI_DELEGATE_CGROUP] = { "delegate-cgroup", TYPE_STRING },
+  [RUN_OCI_HANDLER] = { "handler", TYPE_STRING },
+  [RUN_OCI_HOOKS_PARALLEL] = { "hooks.parallel", TYPE_STRING },
+  [RUN_OCI_HOOKS_STDERR] = { "hooks.stderr", TYPE_STRING },
+  [RUN_OCI_HOOKS_STDOUT] = { "hooks.stdout", TYPE_STRING },
+  [RUN_OCI_KEEP_ORIGINAL_GROUPS] = { "keep_original_groups", TYPE_BOOL },
+  [RUN_OCI_MOUNT_CONTEXT_TYPE] = { "mount_context_type", TYPE_STRING },
+  [RUN_OCI_PIDFD_RECEIVER] = { "pidfd_receiver", TYPE_STRING },
+  [RUN_OCI_SECCOMP_PLUGINS] = { "seccomp.plugins", TYPE_STRING },
+  [RUN_OCI_SECCOMP_RECEIVER] = { "seccomp.receiver", TYPE_STRING },
+  [RUN_OCI_SECCOMP_BPF_DATA] = { "seccomp_bpf_data", TYPE_STRING },
+  [RUN_OCI_SECCOMP_FAIL_UNKNOWN_SYSCALL] = { "seccomp_fail_unknown_syscall", TYPE_BOOL },
+  [RUN_OCI_SYSTEMD_FORCE_CGROUP_V1] = { "systemd.force_cgroup_v1", TYPE_STRING },
+  [RUN_OCI_SYSTEMD_SUBGROUP] = { "systemd.subgroup", TYPE_STRING },
+  [RUN_OCI_TERMINAL_BUFFER_SIZE] = { "terminal_buffer_size", TYPE_NUMBER, 1, INT_MAX },
+  [RUN_OCI_TRACE] = { "trace", TYPE_BOOL },
+};
+
+struct run_oci_annotation_value_s
+{
+  const char *value;
+  long long number;
+  bool invalid;
+};
+
+struct run_oci_annotations_s
+{
+  struct run_oci_annotation_value_s values[RUN_OCI_ANNOTATIONS_COUNT];
+
+  /* run.oci.* keys that are not in known_annotations.  */
+  const char **unknown;
+  size_t unknown_len;
+};
+
+static int
+compare_annotation_def (const void *a, const void *b)
+{
+  return strcmp ((const char *) a, ((const struct run_oci_annotation_def_s *) b)->name);
+}
+
+static void
+parse_annotation_value (const struct run_oci_annotation_def_s *def, struct run_oci_annotation_value_s *v)
+{
+  char *endptr = NULL;
+
+  switch (def->type)
+    {
+    case TYPE_BOOL:
+      v->number = strcmp (v->value, "0") != 0;
+      break;
+
+    case TYPE_NUMBER:
+      errno = 0;
+      v->number = strtoll (v->value, &endptr, 10);
+      if (errno != 0 || endptr == v->value || *endptr != '\0' || v->number < def->min || v->number > def->max)
+        v->invalid = true;
+      break;
+    }
+}
+
+struct run_oci_annotations_s *
+run_oci_annotations_index (json_map_string_string *annotations)
+{
+  struct run_oci_annotations_s *index = xmalloc0 (sizeof (*index));
+  size_t i;
+
+  if (annotations == NULL)
+    return index;
+
+  for (i = 0; i < annotations->len; i++)
+    {
+      const struct run_oci_annotation_def_s *def;
+      const char *key = annotations->keys[i];
+      size_t id;
+
+      if (! has_prefix (key, RUN_OCI_PREFIX))
+        continue;
+
+      def = bsearch (key + sizeof (RUN_OCI_PREFIX) - 1, known_annotations, RUN_OCI_ANNOTATIONS_COUNT,
+                     sizeof (known_annotations[0]), compare_annotation_def);
+      if (def == NULL)
+        {
+          index->unknown = xrealloc (index->unknown, (index->unknown_len + 1) * sizeof (*index->unknown));
+          index->unknown[index->unknown_len++] = key;
+          continue;
+        }
+
+      /* The first occurrence wins, as with find_string_map_value.  */
+      id = def - known_annotations;
+      if (index->values[id].value)
+        continue;
+
+      index->values[id].value = annotations->values[i];
+      parse_annotation_value (def, &index->values[id]);
+    }
+
+  return index;
+}
+
+void
+run_oci_annotations_free (struct run_oci_annotations_s *index)
+{
+  if (index == NULL)
+    return;
+
+  free (index->unknown);
+  free (index);
+}
+
+void
+run_oci_annotations_warn (struct run_oci_annotations_s *index)
+{
+  size_t i;
+
+  if (index == NULL)
+    return;
+
+  for (i = 0; i < index->unknown_len; i++)
+    libcrun_warning ("unknown annotation `%s`", index->unknown[i]);
+
+  for (i = 0; i < RUN_OCI_ANNOTATIONS_COUNT; i++)
+    if (index->values[i].invalid)
+      libcrun_warning ("invalid value for `" RUN_OCI_PREFIX "%s`: `%s`", known_annotations[i].name,
+                       index->values[i].value);
+}
+
+const char *
+find_run_oci_annotation (libcrun_container_t *container, enum run_oci_annotation_e id)
+{
+  if (container->run_oci_annotations == NULL)
+    return NULL;
+
+  return container->run_oci_annotations->values[id].value;
+}
+
+bool
+find_run_oci_annotation_bool (libcrun_container_t *container, enum run_oci_annotation_e id, bool def)
+{
+  if (find_run_oci_annotation (container, id) == NULL)
+    return def;
+
+  return container->run_oci_annotations->values[id].number != 0;
+}
+
+long long
+find_run_oci_annotation_number (libcrun_container_t *container, enum run_oci_annotation_e id, long long def)
+{
+  if (find_run_oci_annotation (container, id) == NULL || container->run_oci_annotations->values[id].invalid)
+    return def;
+
+  return container->run_oci_annotations->values[id].number;
+}
@@ -0,0 +1,74 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2025 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ANNOTATIONS_H
+#define ANNOTATIONS_H
+
+#include <config.h>
+#include <stdbool.h>
+
+#include <ocispec/runtime_spec_schema_config_schema.h>
+#include "container.h"
+
+/* The run.oci.* annotations known to crun.  Keep them sorted by name, the
+   same order is used by the table in annotations.c.  */
+enum run_oci_annotation_e
+{
+  RUN_OCI_DELEGATE_CGROUP,
+  RUN_OCI_HANDLER,
+  RUN_OCI_HOOKS_PARALLEL,
+  RUN_OCI_HOOKS_STDERR,
+  RUN_OCI_HOOKS_STDOUT,
+  RUN_OCI_KEEP_ORIGINAL_GROUPS,
+  RUN_OCI_MOUNT_CONTEXT_TYPE,
+  RUN_OCI_PIDFD_RECEIVER,
+  RUN_OCI_SECCOMP_PLUGINS,
+  RUN_OCI_SECCOMP_RECEIVER,
+  RUN_OCI_SECCOMP_BPF_DATA,
+  RUN_OCI_SECCOMP_FAIL_UNKNOWN_SYSCALL,
+  RUN_OCI_SYSTEMD_FORCE_CGROUP_V1,
+  RUN_OCI_SYSTEMD_SUBGROUP,
+  RUN_OCI_TERMINAL_BUFFER_SIZE,
+  RUN_OCI_TRACE,
+  RUN_OCI_ANNOTATIONS_COUNT,
+};
+
+struct run_oci_annotations_s;
+
+/* Index the run.oci.* annotations in ANNOTATIONS.  The values are parsed
+   once here, the returned object points into ANNOTATIONS so it must not
+   outlive it.  */
+struct run_oci_annotations_s *run_oci_annotations_index (json_map_string_string *annotations);
+
+void run_oci_annotations_free (struct run_oci_annotations_s *index);
+
+/* Report the unknown run.oci.* annotations and the values that could not
+   be parsed.  */
+void run_oci_annotations_warn (struct run_oci_annotations_s *index);
+
+/* Return the value of the annotation ID, or NULL if it is not set.  */
+const char *find_run_oci_annotation (libcrun_container_t *container, enum run_oci_annotation_e id);
+
+/* Return true if the annotation ID is set to anything different than "0",
+   DEF if it is not set.  */
+bool find_run_oci_annotation_bool (libcrun_container_t *container, enum run_oci_annotation_e id, bool def);
+
+/* Return the numeric value of the annotation ID, DEF if it is not set or
+   it is not a valid number.  */
+long long find_run_oci_annotation_number (libcrun_container_t *container, enum run_oci_annotation_e id, long long def);
+
+#endif
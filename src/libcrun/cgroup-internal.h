@@ -43,6 +43,10 @@ struct libcrun_cgroup_status
   int manager;
 
   bool bpf_dev_set;
+
+  /* Set by the manager when create_cgroup returned before the cgroup
+     is ready.  It is completed by join_cgroup.  */
+  void *pending;
 };
 
 struct libcrun_cgroup_manager
@@ -54,6 +58,12 @@ struct libcrun_cgroup_manager
   int (*destroy_cgroup) (struct libcrun_cgroup_status *cgroup_status, libcrun_error_t *err);
   /* Additional resources configuration specific to this manager.  */
   int (*update_resources) (struct libcrun_cgroup_status *cgroup_status, const char *state_root, runtime_spec_schema_config_linux_resources *resources, libcrun_error_t *err);
+  /* Same as update_resources, for N cgroups at once.  Optional.  */
+  int (*update_resources_many) (struct libcrun_cgroup_status **cgroup_status, const char *state_root, runtime_spec_schema_config_linux_resources **resources, size_t n, libcrun_error_t *err);
+  /* Wait for a cgroup created asynchronously and fill PATH in OUT.  */
+  int (*join_cgroup) (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status *out, libcrun_error_t *err);
+  /* Release the pending state of a cgroup that was never joined.  */
+  void (*free_pending) (void *pending);
 };
 
 int move_process_to_cgroup (pid_t pid, const char *subsystem, const char *path, libcrun_error_t *err);
@@ -0,0 +1,406 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _GNU_SOURCE
+
+#include <config.h>
+#include "cgroup-stats.h"
+#include "cgroup-internal.h"
+#include "cgroup-utils.h"
+#include "utils.h"
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define YAJL_STR(x) ((const unsigned char *) (x))
+
+static const char *stat_files[] = {
+  "cpu.stat",
+  "memory.current",
+  "memory.events",
+  "io.stat",
+  "pids.current",
+};
+
+#define N_STAT_FILES (sizeof (stat_files) / sizeof (stat_files[0]))
+
+struct stat_value
+{
+  char *key;
+  unsigned long long value;
+};
+
+struct stat_values
+{
+  struct stat_value *values;
+  size_t len;
+};
+
+struct stat_file
+{
+  const char *name;
+  int fd;
+  struct stat_values last;
+};
+
+struct libcrun_cgroup_stats
+{
+  int dirfd;
+  int memory_events_fd;
+  int cgroup_events_fd;
+  bool empty;
+  struct stat_values memory_events;
+  struct stat_file files[N_STAT_FILES];
+
+  /* Reused for every read.  */
+  char *buffer;
+  size_t buffer_size;
+};
+
+static void
+free_stat_values (struct stat_values *v)
+{
+  size_t i;
+
+  for (i = 0; i < v->len; i++)
+    free (v->values[i].key);
+  free (v->values);
+  v->values = NULL;
+  v->len = 0;
+}
+
+static void
+add_stat_value (struct stat_values *v, const char *prefix, const char *key, size_t key_len, unsigned long long value)
+{
+  struct stat_value *it;
+
+  v->values = xrealloc (v->values, (v->len + 1) * sizeof (*v->values));
+  it = &v->values[v->len++];
+  if (prefix)
+    xasprintf (&it->key, "%s.%.*s", prefix, (int) key_len, key);
+  else
+    xasprintf (&it->key, "%.*s", (int) key_len, key);
+  it->value = value;
+}
+
+/* Re-read FD from the beginning.  The file is not reopened, so that a
+   sample costs a single pread(2) per file.  */
+static int
+read_stat_fd (struct libcrun_cgroup_stats *stats, int fd, const char *name, libcrun_error_t *err)
+{
+  size_t used = 0;
+
+  for (;;)
+    {
+      ssize_t r;
+
+      if (stats->buffer_size - used < 2)
+        {
+          stats->buffer_size = stats->buffer_size ? stats->buffer_size * 2 : 4096;
+          stats->buffer = xrealloc (stats->buffer, stats->buffer_size);
+        }
+
+      r = TEMP_FAILURE_RETRY (pread (fd, stats->buffer + used, stats->buffer_size - used - 1, used));
+      if (UNLIKELY (r < 0))
+        return crun_make_error (err, errno, "read `%s`", name);
+      if (r == 0)
+        break;
+      used += r;
+    }
+  stats->buffer[used] = '\0';
+  return 0;
+}
+
+/* Parse the formats used by the cgroup v2 stat files:
+
+   VALUE
+   KEY VALUE
+   KEY SUBKEY=VALUE SUBKEY=VALUE...  */
+static void
+parse_stat_values (char *content, struct stat_values *out)
+{
+  char *saveptr = NULL;
+  char *line;
+
+  for (line = strtok_r (content, "\n", &saveptr); line; line = strtok_r (NULL, "\n", &saveptr))
+    {
+      char *value = strchr (line, ' ');
+      char *tok_saveptr = NULL;
+      char *tok;
+
+      if (value == NULL)
+        {
+          add_stat_value (out, NULL, "", 0, strtoull (line, NULL, 10));
+          continue;
+        }
+
+      *value++ = '\0';
+      if (strchr (value, '=') == NULL)
+        {
+          add_stat_value (out, NULL, line, strlen (line), strtoull (value, NULL, 10));
+          continue;
+        }
+
+      for (tok = strtok_r (value, " ", &tok_saveptr); tok; tok = strtok_r (NULL, " ", &tok_saveptr))
+        {
+          char *eq = strchr (tok, '=');
+          if (eq == NULL)
+            continue;
+          add_stat_value (out, line, tok, eq - tok, strtoull (eq + 1, NULL, 10));
+        }
+    }
+}
+
+static const struct stat_value *
+find_stat_value (const struct stat_values *v, size_t hint, const char *key)
+{
+  size_t i;
+
+  /* The files list the keys in the same order every time.  */
+  if (hint < v->len && strcmp (v->values[hint].key, key) == 0)
+    return &v->values[hint];
+
+  for (i = 0; i < v->len; i++)
+    if (strcmp (v->values[i].key, key) == 0)
+      return &v->values[i];
+
+  return NULL;
+}
+
+int
+libcrun_cgroup_stats_open (struct libcrun_cgroup_status *cgroup_status, struct libcrun_cgroup_stats **out,
+                           libcrun_error_t *err)
+{
+  struct libcrun_cgroup_stats *stats;
+  size_t i;
+  int dirfd;
+  int ret;
+
+  dirfd = libcrun_get_cgroup_dirfd (cgroup_status, NULL, err);
+  if (UNLIKELY (dirfd < 0))
+    return dirfd;
+
+  stats = xmalloc0 (sizeof (*stats));
+  stats->dirfd = dirfd;
+
+  for (i = 0; i < N_STAT_FILES; i++)
+    {
+      stats->files[i].name = stat_files[i];
+      stats->files[i].fd = openat (dirfd, stat_files[i], O_RDONLY | O_CLOEXEC);
+    }
+
+  /* A separate fd is used for the notifications, so that reading it does
+     not affect the deltas.  It is missing if the memory controller is
+     not enabled.  */
+  stats->memory_events_fd = openat (dirfd, "memory.events", O_RDONLY | O_CLOEXEC);
+
+  stats->cgroup_events_fd = openat (dirfd, "cgroup.events", O_RDONLY | O_CLOEXEC);
+  if (UNLIKELY (stats->cgroup_events_fd < 0))
+    {
+      ret = crun_make_error (err, errno, "open `cgroup.events`");
+      goto fail;
+    }
+
+  /* The notification is not raised for the state at open time, so check
+     it now.  */
+  ret = read_stat_fd (stats, stats->cgroup_events_fd, "cgroup.events", err);
+  if (UNLIKELY (ret < 0))
+    goto fail;
+  stats->empty = strstr (stats->buffer, "populated 0") != NULL;
+
+  /* Take the initial values, so that only the events happening from now
+     on are reported.  */
+  if (stats->memory_events_fd >= 0)
+    {
+      ret = read_stat_fd (stats, stats->memory_events_fd, "memory.events", err);
+      if (UNLIKELY (ret < 0))
+        goto fail;
+
+      parse_stat_values (stats->buffer, &stats->memory_events);
+    }
+
+  *out = stats;
+  return 0;
+
+fail:
+  libcrun_cgroup_stats_free (stats);
+  return ret;
+}
+
+void
+libcrun_cgroup_stats_free (struct libcrun_cgroup_stats *stats)
+{
+  size_t i;
+
+  if (stats == NULL)
+    return;
+
+  for (i = 0; i < N_STAT_FILES; i++)
+    {
+      if (stats->files[i].fd >= 0)
+        close (stats->files[i].fd);
+      free_stat_values (&stats->files[i].last);
+    }
+  if (stats->memory_events_fd >= 0)
+    close (stats->memory_events_fd);
+  if (stats->cgroup_events_fd >= 0)
+    close (stats->cgroup_events_fd);
+  if (stats->dirfd >= 0)
+    close (stats->dirfd);
+  free_stat_values (&stats->memory_events);
+  free (stats->buffer);
+  free (stats);
+}
+
+static int
+generate_stat_file (struct libcrun_cgroup_stats *stats, struct stat_file *file, yajl_gen gen, bool delta,
+                    libcrun_error_t *err)
+{
+  struct stat_values current = {};
+  bool *changed = NULL;
+  size_t i, n_changed = 0;
+  int ret;
+
+  ret = read_stat_fd (stats, file->fd, file->name, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  parse_stat_values (stats->buffer, &current);
+
+  changed = xmalloc0 (current.len * sizeof (bool) + 1);
+  for (i = 0; i < current.len; i++)
+    {
+      const struct stat_value *prev = find_stat_value (&file->last, i, current.values[i].key);
+
+      changed[i] = ! delta || prev == NULL || prev->value != current.values[i].value;
+      if (changed[i])
+        n_changed++;
+    }
+
+  if (n_changed > 0)
+    {
+      yajl_gen_string (gen, YAJL_STR (file->name), strlen (file->name));
+      if (current.len == 1 && current.values[0].key[0] == '\0')
+        yajl_gen_integer (gen, (long long) current.values[0].value);
+      else
+        {
+          yajl_gen_map_open (gen);
+          for (i = 0; i < current.len; i++)
+            {
+              if (! changed[i])
+                continue;
+              yajl_gen_string (gen, YAJL_STR (current.values[i].key), strlen (current.values[i].key));
+              yajl_gen_integer (gen, (long long) current.values[i].value);
+            }
+          yajl_gen_map_close (gen);
+        }
+    }
+
+  free (changed);
+  free_stat_values (&file->last);
+  file->last = current;
+
+  return n_changed;
+}
+
+int
+libcrun_cgroup_stats_generate (struct libcrun_cgroup_stats *stats, yajl_gen gen, bool delta, libcrun_error_t *err)
+{
+  size_t i;
+  int total = 0;
+
+  yajl_gen_map_open (gen);
+  for (i = 0; i < N_STAT_FILES; i++)
+    {
+      int ret;
+
+      if (stats->files[i].fd < 0)
+        continue;
+
+      ret = generate_stat_file (stats, &stats->files[i], gen, delta, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+      total += ret;
+    }
+  yajl_gen_map_close (gen);
+
+  return total;
+}
+
+int
+libcrun_cgroup_stats_wait (struct libcrun_cgroup_stats *stats, int timeout, libcrun_error_t *err)
+{
+  struct pollfd fds[2];
+  nfds_t nfds = 0;
+  int ret, mask = 0;
+
+  if (stats->empty)
+    return LIBCRUN_CGROUP_STATS_EMPTY;
+
+  /* kernfs signals a modification of these files with POLLPRI.  */
+  fds[nfds].fd = stats->cgroup_events_fd;
+  fds[nfds++].events = POLLPRI;
+  if (stats->memory_events_fd >= 0)
+    {
+      fds[nfds].fd = stats->memory_events_fd;
+      fds[nfds++].events = POLLPRI;
+    }
+
+  ret = poll (fds, nfds, timeout);
+  if (UNLIKELY (ret < 0))
+    {
+      if (errno == EINTR)
+        return 0;
+      return crun_make_error (err, errno, "poll");
+    }
+  if (ret == 0)
+    return 0;
+
+  if (fds[0].revents)
+    {
+      /* Reading the file also re-arms the notification.  */
+      ret = read_stat_fd (stats, stats->cgroup_events_fd, "cgroup.events", err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      stats->empty = strstr (stats->buffer, "populated 0") != NULL;
+      if (stats->empty)
+        mask |= LIBCRUN_CGROUP_STATS_EMPTY;
+    }
+
+  if (nfds > 1 && fds[1].revents)
+    {
+      ret = read_stat_fd (stats, stats->memory_events_fd, "memory.events", err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      free_stat_values (&stats->memory_events);
+      parse_stat_values (stats->buffer, &stats->memory_events);
+      mask |= LIBCRUN_CGROUP_STATS_MEMORY_EVENTS;
+    }
+
+  return mask;
+}
+
+unsigned long long
+libcrun_cgroup_stats_get_memory_event (struct libcrun_cgroup_stats *stats, const char *key)
+{
+  const struct stat_value *v = find_stat_value (&stats->memory_events, 0, key);
+
+  return v ? v->value : 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CGROUP_STATS_H
+#define CGROUP_STATS_H
+
+#include "container.h"
+#include "cgroup.h"
+#include <yajl/yajl_gen.h>
+
+struct libcrun_cgroup_stats;
+
+enum
+{
+  /* memory.events was modified.  */
+  LIBCRUN_CGROUP_STATS_MEMORY_EVENTS = 1 << 0,
+  /* The cgroup has no more processes.  */
+  LIBCRUN_CGROUP_STATS_EMPTY = 1 << 1,
+};
+
+/* Open the cgroup v2 directory and its stat files once, they are re-read
+   in place on every sample.  */
+int libcrun_cgroup_stats_open (struct libcrun_cgroup_status *cgroup_status, struct libcrun_cgroup_stats **out,
+                               libcrun_error_t *err);
+
+void libcrun_cgroup_stats_free (struct libcrun_cgroup_stats *stats);
+
+/* Read all the stat files and generate a map with their values.  If DELTA
+   is set, only the values that changed since the previous call are
+   generated.  Returns the number of values generated.  */
+int libcrun_cgroup_stats_generate (struct libcrun_cgroup_stats *stats, yajl_gen gen, bool delta, libcrun_error_t *err);
+
+/* Wait up to TIMEOUT milliseconds for a change notification on
+   memory.events or cgroup.events.  Returns a mask of
+   LIBCRUN_CGROUP_STATS_*, or 0 on timeout.  */
+int libcrun_cgroup_stats_wait (struct libcrun_cgroup_stats *stats, int timeout, libcrun_error_t *err);
+
+/* Return the value of KEY in memory.events, as of the last read.  */
+unsigned long long libcrun_cgroup_stats_get_memory_event (struct libcrun_cgroup_stats *stats, const char *key);
+
+static inline void
+cgroup_stats_freep (struct libcrun_cgroup_stats **p)
+{
+  if (*p)
+    libcrun_cgroup_stats_free (*p);
+}
+#define cleanup_cgroup_stats __attribute__ ((cleanup (cgroup_stats_freep)))
+
+#endif
@@ -482,7 +482,7 @@ systemd_job_removed (sd_bus_message *m, void *userdata, sd_bus_error *error arg_
   if (ret < 0)
     return -1;
 
-  if (strcmp (d->path, path) == 0)
+  if (d->path && strcmp (d->path, path) == 0)
     {
       d->terminated = 1;
       if (strcmp (result, "done") != 0)
@@ -494,12 +494,15 @@ systemd_job_removed (sd_bus_message *m, void *userdata, sd_bus_error *error arg_
   return 0;
 }
 
+/* The match is bound to SLOT, which must be released before DATA goes
+   out of scope: the connection is cached and outlives the caller.  */
 static int
-systemd_check_job_status_setup (sd_bus *bus, struct systemd_job_removed_s *data, libcrun_error_t *err)
+systemd_check_job_status_setup (sd_bus *bus, sd_bus_slot **slot, struct systemd_job_removed_s *data,
+                                libcrun_error_t *err)
 {
   int ret;
 
-  ret = sd_bus_match_signal_async (bus, NULL, "org.freedesktop.systemd1", "/org/freedesktop/systemd1",
+  ret = sd_bus_match_signal_async (bus, slot, "org.freedesktop.systemd1", "/org/freedesktop/systemd1",
                                    "org.freedesktop.systemd1.Manager", "JobRemoved", systemd_job_removed, NULL, data);
   if (UNLIKELY (ret < 0))
     return crun_make_error (err, -ret, "sd-bus match signal");
@@ -778,9 +781,23 @@ append_systemd_annotation (sd_bus_message *m, const char *name, size_t name_len,
   return crun_make_error (err, errno, "unknown type for `%s`", name);
 }
 
+/* The connection is cached and reused by the following calls from the
+   same process, so that a long running user of libcrun does not pay
+   for the connection setup and authentication on every operation.  A
+   connection cannot be used after fork(), so it is dropped when the
+   pid changes.  */
+static struct
+{
+  sd_bus *bus;
+  pid_t pid;
+  bool user;
+} cached_sd_bus;
+
 static int
 open_sd_bus_connection (sd_bus **bus, libcrun_error_t *err)
 {
+  bool user = false;
+  pid_t pid = getpid ();
   int rootless;
   int sd_err = 0;
 
@@ -788,13 +805,36 @@ open_sd_bus_connection (sd_bus **bus, libcrun_error_t *err)
   if (UNLIKELY (rootless < 0))
     return rootless;
 
+  if (cached_sd_bus.bus)
+    {
+      if (cached_sd_bus.pid == pid && sd_bus_is_open (cached_sd_bus.bus) > 0
+          && (rootless || ! cached_sd_bus.user))
+        {
+          *bus = sd_bus_ref (cached_sd_bus.bus);
+          return 0;
+        }
+
+      /* The connection belongs to the parent process, it must not be
+         touched.  */
+      if (cached_sd_bus.pid == pid)
+        sd_bus_unref (cached_sd_bus.bus);
+      cached_sd_bus.bus = NULL;
+    }
+
   if (rootless)
-    sd_err = sd_bus_default_user (bus);
+    {
+      sd_err = sd_bus_open_user (bus);
+      user = sd_err >= 0;
+    }
   if (! rootless || sd_err < 0)
-    sd_err = sd_bus_default_system (bus);
+    sd_err = sd_bus_open_system (bus);
   if (sd_err < 0)
     return crun_make_error (err, -sd_err, "cannot open sd-bus");
 
+  cached_sd_bus.bus = sd_bus_ref (*bus);
+  cached_sd_bus.pid = pid;
+  cached_sd_bus.user = user;
+
   return 0;
 }
 
@@ -1729,33 +1769,20 @@ verify_ebpf_device_filter_installed (const char *cgroup_path, libcrun_error_t *e
 }
 
 static int
-enter_systemd_cgroup_scope (runtime_spec_schema_config_linux_resources *resources,
-                            int cgroup_mode,
-                            string_map *annotations,
-                            const char *state_root,
-                            const char *scope, const char *slice,
-                            pid_t pid,
-                            bool *can_retry,
-                            bool *devices_set,
-                            libcrun_error_t *err)
+make_start_transient_unit_message (sd_bus *bus, sd_bus_message **out,
+                                   runtime_spec_schema_config_linux_resources *resources,
+                                   int cgroup_mode,
+                                   string_map *annotations,
+                                   const char *state_dir,
+                                   const char *scope, const char *slice,
+                                   pid_t pid,
+                                   bool *devices_set,
+                                   libcrun_error_t *err)
 {
-  sd_bus *bus = NULL;
   sd_bus_message *m = NULL;
-  sd_bus_message *reply = NULL;
   int sd_err, ret = 0;
-  sd_bus_error error = SD_BUS_ERROR_NULL;
-  const char *object = NULL;
-  struct systemd_job_removed_s job_data = {};
   int i;
   const char *boolean_opts[10];
-  cleanup_free char *state_dir = NULL;
-
-  *can_retry = false;
-  *devices_set = false;
-
-  ret = libcrun_get_state_directory (&state_dir, state_root, NULL, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
 
   i = 0;
   boolean_opts[i++] = "Delegate";
@@ -1768,21 +1795,10 @@ enter_systemd_cgroup_scope (runtime_spec_schema_config_linux_resources *resource
   boolean_opts[i++] = "TasksAccounting";
   boolean_opts[i++] = NULL;
 
-  ret = open_sd_bus_connection (&bus, err);
-  if (UNLIKELY (ret < 0))
-    goto exit;
-
-  ret = systemd_check_job_status_setup (bus, &job_data, err);
-  if (UNLIKELY (ret < 0))
-    goto exit;
-
   sd_err = sd_bus_message_new_method_call (bus, &m, "org.freedesktop.systemd1", "/org/freedesktop/systemd1",
                                            "org.freedesktop.systemd1.Manager", "StartTransientUnit");
   if (UNLIKELY (sd_err < 0))
-    {
-      ret = crun_make_error (err, -sd_err, "set up dbus message");
-      goto exit;
-    }
+    return crun_make_error (err, -sd_err, "set up dbus message");
 
   sd_err = sd_bus_message_append (m, "ss", scope, "fail");
   if (UNLIKELY (sd_err < 0))
@@ -1893,6 +1909,56 @@ enter_systemd_cgroup_scope (runtime_spec_schema_config_linux_resources *resource
       goto exit;
     }
 
+  *out = m;
+  m = NULL;
+
+exit:
+  if (m)
+    sd_bus_message_unref (m);
+  return ret;
+}
+
+static int
+enter_systemd_cgroup_scope (runtime_spec_schema_config_linux_resources *resources,
+                            int cgroup_mode,
+                            string_map *annotations,
+                            const char *state_root,
+                            const char *scope, const char *slice,
+                            pid_t pid,
+                            bool *can_retry,
+                            bool *devices_set,
+                            libcrun_error_t *err)
+{
+  sd_bus *bus = NULL;
+  sd_bus_message *m = NULL;
+  sd_bus_message *reply = NULL;
+  int sd_err, ret = 0;
+  sd_bus_error error = SD_BUS_ERROR_NULL;
+  const char *object = NULL;
+  struct systemd_job_removed_s job_data = {};
+  sd_bus_slot *job_slot = NULL;
+  cleanup_free char *state_dir = NULL;
+
+  *can_retry = false;
+  *devices_set = false;
+
+  ret = libcrun_get_state_directory (&state_dir, state_root, NULL, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = open_sd_bus_connection (&bus, err);
+  if (UNLIKELY (ret < 0))
+    goto exit;
+
+  ret = systemd_check_job_status_setup (bus, &job_slot, &job_data, err);
+  if (UNLIKELY (ret < 0))
+    goto exit;
+
+  ret = make_start_transient_unit_message (bus, &m, resources, cgroup_mode, annotations, state_dir, scope, slice,
+                                           pid, devices_set, err);
+  if (UNLIKELY (ret < 0))
+    goto exit;
+
   sd_err = sd_bus_call (bus, m, 0, &error, &reply);
   if (UNLIKELY (sd_err < 0))
     {
@@ -1932,6 +1998,8 @@ enter_systemd_cgroup_scope (runtime_spec_schema_config_linux_resources *resource
   ret = systemd_check_job_status (bus, &job_data, object, "creating", err);
 
 exit:
+  if (job_slot)
+    sd_bus_slot_unref (job_slot);
   if (bus)
     sd_bus_unref (bus);
   if (m)
@@ -1954,12 +2022,13 @@ libcrun_destroy_systemd_cgroup_scope (struct libcrun_cgroup_status *cgroup_statu
   const char *object;
   const char *scope = cgroup_status->scope;
   struct systemd_job_removed_s job_data = {};
+  sd_bus_slot *job_slot = NULL;
 
   ret = open_sd_bus_connection (&bus, err);
   if (UNLIKELY (ret < 0))
     goto exit;
 
-  ret = systemd_check_job_status_setup (bus, &job_data, err);
+  ret = systemd_check_job_status_setup (bus, &job_slot, &job_data, err);
   if (UNLIKELY (ret < 0))
     goto exit;
 
@@ -1998,6 +2067,8 @@ libcrun_destroy_systemd_cgroup_scope (struct libcrun_cgroup_status *cgroup_statu
   reset_failed_unit (bus, scope);
 
 exit:
+  if (job_slot)
+    sd_bus_slot_unref (job_slot);
   if (bus)
     sd_bus_unref (bus);
   if (m)
@@ -2024,45 +2095,166 @@ find_systemd_subgroup (string_map *annotations)
   return "container";
 }
 
-static int
-libcrun_cgroup_enter_systemd (struct libcrun_cgroup_args *args,
-                              struct libcrun_cgroup_status *out,
-                              libcrun_error_t *err)
+struct systemd_pending_scope_s
 {
-  runtime_spec_schema_config_linux_resources *resources = args->resources;
-  const char *cgroup_path = args->cgroup_path;
-  cleanup_free char *scope = NULL;
-  cleanup_free char *path = NULL;
-  cleanup_free char *slice = NULL;
-  int retries_left = 32;
-  const char *suffix;
-  const char *id = args->id;
-  pid_t pid = args->pid;
+  sd_bus *bus;
+  sd_bus_slot *slot;
+  sd_bus_slot *job_slot;
+  sd_bus_message *reply;
+  sd_bus_error error;
+  bool replied;
+
   int cgroup_mode;
-  int rootless = 0;
-  int ret;
+  char *slice;
+  struct systemd_job_removed_s job_data;
+};
 
-  cgroup_mode = libcrun_get_cgroup_mode (err);
-  if (UNLIKELY (cgroup_mode < 0))
-    return cgroup_mode;
+static void
+free_systemd_pending_scope (void *data)
+{
+  struct systemd_pending_scope_s *pending = data;
+
+  if (pending == NULL)
+    return;
+
+  if (pending->slot)
+    sd_bus_slot_unref (pending->slot);
+  if (pending->job_slot)
+    sd_bus_slot_unref (pending->job_slot);
+  if (pending->reply)
+    sd_bus_message_unref (pending->reply);
+  if (pending->bus)
+    sd_bus_unref (pending->bus);
+  sd_bus_error_free (&pending->error);
+  free (pending->slice);
+  free (pending);
+}
 
-  if (cgroup_mode == CGROUP_MODE_UNIFIED)
+static int
+start_transient_unit_reply (sd_bus_message *m, void *userdata, sd_bus_error *ret_error arg_unused)
+{
+  struct systemd_pending_scope_s *pending = userdata;
+  const char *object = NULL;
+
+  pending->replied = true;
+
+  if (sd_bus_message_is_method_error (m, NULL))
     {
-      rootless = is_rootless (err);
-      if (UNLIKELY (rootless < 0))
-        return rootless;
+      sd_bus_error_copy (&pending->error, sd_bus_message_get_error (m));
+      return 0;
     }
 
-  get_systemd_scope_and_slice (id, rootless == 1, cgroup_path, &scope, &slice);
+  if (sd_bus_message_read (m, "o", &object) < 0)
+    {
+      sd_bus_error_set_const (&pending->error, SD_BUS_ERROR_INVALID_ARGS, "invalid StartTransientUnit reply");
+      return 0;
+    }
+
+  /* The JobRemoved signal follows the reply, so the job path is known
+     before it is dispatched.  */
+  pending->reply = sd_bus_message_ref (m);
+  pending->job_data.path = object;
+  pending->job_data.op = "creating";
+  return 0;
+}
+
+/* Send StartTransientUnit without waiting for the reply.  The caller
+   continues with the container setup while systemd creates the scope.  */
+static int
+start_systemd_cgroup_scope_async (struct libcrun_cgroup_args *args, int cgroup_mode,
+                                  const char *scope, const char *slice,
+                                  struct systemd_pending_scope_s **out,
+                                  bool *devices_set,
+                                  libcrun_error_t *err)
+{
+  struct systemd_pending_scope_s *pending;
+  cleanup_free char *state_dir = NULL;
+  sd_bus_message *m = NULL;
+  int sd_err, ret;
+
+  *devices_set = false;
+
+  ret = libcrun_get_state_directory (&state_dir, args->state_root, NULL, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  pending = xmalloc0 (sizeof (*pending));
+  pending->error = SD_BUS_ERROR_NULL;
+  pending->cgroup_mode = cgroup_mode;
+  pending->slice = slice ? xstrdup (slice) : NULL;
+
+  ret = open_sd_bus_connection (&pending->bus, err);
+  if (UNLIKELY (ret < 0))
+    goto fail;
+
+  ret = systemd_check_job_status_setup (pending->bus, &pending->job_slot, &pending->job_data, err);
+  if (UNLIKELY (ret < 0))
+    goto fail;
+
+  ret = make_start_transient_unit_message (pending->bus, &m, args->resources, cgroup_mode, args->annotations,
+                                           state_dir, scope, slice, args->pid, devices_set, err);
+  if (UNLIKELY (ret < 0))
+    goto fail;
+
+  sd_err = sd_bus_call_async (pending->bus, &pending->slot, m, start_transient_unit_reply, pending, 0);
+  sd_bus_message_unref (m);
+  if (UNLIKELY (sd_err < 0))
+    {
+      ret = crun_make_error (err, -sd_err, "sd-bus call async");
+      goto fail;
+    }
+
+  *out = pending;
+  return 0;
+
+fail:
+  free_systemd_pending_scope (pending);
+  return ret;
+}
+
+/* Wait for the reply to StartTransientUnit and then for the job to
+   complete.  Returns 1 if the call itself failed and the scope must be
+   created again synchronously.  */
+static int
+wait_systemd_cgroup_scope (struct systemd_pending_scope_s *pending, libcrun_error_t *err)
+{
+  int sd_err;
+
+  while (! pending->replied)
+    {
+      sd_err = sd_bus_process (pending->bus, NULL);
+      if (UNLIKELY (sd_err < 0))
+        return crun_make_error (err, -sd_err, "sd-bus process");
+
+      if (sd_err != 0)
+        continue;
+
+      sd_err = sd_bus_wait (pending->bus, (uint64_t) -1);
+      if (UNLIKELY (sd_err < 0))
+        return crun_make_error (err, -sd_err, "sd-bus wait");
+    }
+
+  if (pending->reply == NULL)
+    return 1;
+
+  return systemd_check_job_status (pending->bus, &pending->job_data, pending->job_data.path, "creating", err);
+}
+
+static int
+create_systemd_cgroup_scope (struct libcrun_cgroup_args *args, int cgroup_mode, const char *scope,
+                             const char *slice, bool *devices_set, libcrun_error_t *err)
+{
+  int retries_left = 32;
+  int ret;
 
   for (;;)
     {
       bool can_retry = false;
 
-      ret = enter_systemd_cgroup_scope (resources, cgroup_mode, args->annotations, args->state_root,
-                                        scope, slice, pid, &can_retry, &out->bpf_dev_set, err);
+      ret = enter_systemd_cgroup_scope (args->resources, cgroup_mode, args->annotations, args->state_root,
+                                        scope, slice, args->pid, &can_retry, devices_set, err);
       if (LIKELY (ret >= 0))
-        break;
+        return 0;
 
       if (can_retry && retries_left-- > 0)
         {
@@ -2072,6 +2264,16 @@ libcrun_cgroup_enter_systemd (struct libcrun_cgroup_args *args,
 
       return ret;
     }
+}
+
+/* Move the process to the subgroup and fill OUT, once the scope exists.  */
+static int
+complete_systemd_cgroup_enter (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status *out,
+                               int cgroup_mode, libcrun_error_t *err)
+{
+  cleanup_free char *path = NULL;
+  const char *suffix;
+  int ret;
 
   suffix = find_systemd_subgroup (args->annotations);
 
@@ -2105,12 +2307,88 @@ libcrun_cgroup_enter_systemd (struct libcrun_cgroup_args *args,
 
   out->path = path;
   path = NULL;
+  return 0;
+}
+
+static int
+libcrun_cgroup_enter_systemd (struct libcrun_cgroup_args *args,
+                              struct libcrun_cgroup_status *out,
+                              libcrun_error_t *err)
+{
+  const char *cgroup_path = args->cgroup_path;
+  cleanup_free char *scope = NULL;
+  cleanup_free char *slice = NULL;
+  const char *id = args->id;
+  int cgroup_mode;
+  int rootless = 0;
+  int ret;
+
+  cgroup_mode = libcrun_get_cgroup_mode (err);
+  if (UNLIKELY (cgroup_mode < 0))
+    return cgroup_mode;
+
+  if (cgroup_mode == CGROUP_MODE_UNIFIED)
+    {
+      rootless = is_rootless (err);
+      if (UNLIKELY (rootless < 0))
+        return rootless;
+    }
+
+  get_systemd_scope_and_slice (id, rootless == 1, cgroup_path, &scope, &slice);
+
+  if (args->async)
+    {
+      struct systemd_pending_scope_s *pending = NULL;
+
+      ret = start_systemd_cgroup_scope_async (args, cgroup_mode, scope, slice, &pending, &out->bpf_dev_set, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      out->pending = pending;
+      out->scope = scope;
+      scope = NULL;
+      return 0;
+    }
+
+  ret = create_systemd_cgroup_scope (args, cgroup_mode, scope, slice, &out->bpf_dev_set, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = complete_systemd_cgroup_enter (args, out, cgroup_mode, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
 
   out->scope = scope;
   scope = NULL;
   return 0;
 }
 
+static int
+libcrun_cgroup_join_systemd (struct libcrun_cgroup_args *args,
+                             struct libcrun_cgroup_status *out,
+                             libcrun_error_t *err)
+{
+  struct systemd_pending_scope_s *pending = out->pending;
+  int ret;
+
+  out->pending = NULL;
+
+  ret = wait_systemd_cgroup_scope (pending, err);
+  if (ret > 0)
+    {
+      /* The call failed, e.g. the unit exists in a failed state or a
+         property is not supported.  Let the synchronous path deal with
+         it, it knows how to recover.  */
+      ret = create_systemd_cgroup_scope (args, pending->cgroup_mode, out->scope, pending->slice,
+                                         &out->bpf_dev_set, err);
+    }
+  if (LIKELY (ret >= 0))
+    ret = complete_systemd_cgroup_enter (args, out, pending->cgroup_mode, err);
+
+  free_systemd_pending_scope (pending);
+  return ret;
+}
+
 char *
 get_cgroup_scope_path (const char *cgroup_path, const char *scope)
 {
@@ -2152,9 +2430,13 @@ libcrun_destroy_cgroup_systemd (struct libcrun_cgroup_status *cgroup_status,
   if (UNLIKELY (mode < 0))
     return mode;
 
-  ret = cgroup_killall_path (cgroup_status->path, SIGKILL, err);
-  if (UNLIKELY (ret < 0))
-    crun_error_release (err);
+  /* The path is not known yet if the scope was never joined.  */
+  if (cgroup_status->path)
+    {
+      ret = cgroup_killall_path (cgroup_status->path, SIGKILL, err);
+      if (UNLIKELY (ret < 0))
+        crun_error_release (err);
+    }
 
   ret = libcrun_destroy_systemd_cgroup_scope (cgroup_status, err);
   if (UNLIKELY (ret < 0))
@@ -2166,51 +2448,28 @@ libcrun_destroy_cgroup_systemd (struct libcrun_cgroup_status *cgroup_status,
   else
     unlink (bpfprog); // Best effort.
 
+  if (cgroup_status->path == NULL)
+    return 0;
+
   path_to_scope = get_cgroup_scope_path (cgroup_status->path, cgroup_status->scope);
 
   return destroy_cgroup_path (path_to_scope, mode, err);
 }
 
 static int
-libcrun_update_resources_systemd (struct libcrun_cgroup_status *cgroup_status,
-                                  const char *state_root,
-                                  runtime_spec_schema_config_linux_resources *resources,
-                                  libcrun_error_t *err)
+make_set_unit_properties_message (sd_bus *bus, sd_bus_message **out, struct libcrun_cgroup_status *cgroup_status,
+                                  const char *state_dir, runtime_spec_schema_config_linux_resources *resources,
+                                  int cgroup_mode, libcrun_error_t *err)
 {
-  struct systemd_job_removed_s job_data = {};
-  sd_bus_error error = SD_BUS_ERROR_NULL;
-  cleanup_free char *state_dir = NULL;
-  sd_bus_message *reply = NULL;
   sd_bus_message *m = NULL;
-  sd_bus *bus = NULL;
   int sd_err, ret;
-  int cgroup_mode;
-
-  ret = libcrun_get_state_directory (&state_dir, state_root, NULL, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
-
-  cgroup_mode = libcrun_get_cgroup_mode (err);
-  if (UNLIKELY (cgroup_mode < 0))
-    return cgroup_mode;
-
-  ret = open_sd_bus_connection (&bus, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
-
-  ret = systemd_check_job_status_setup (bus, &job_data, err);
-  if (UNLIKELY (ret < 0))
-    goto exit;
 
   sd_err = sd_bus_message_new_method_call (bus, &m, "org.freedesktop.systemd1",
                                            "/org/freedesktop/systemd1",
                                            "org.freedesktop.systemd1.Manager",
                                            "SetUnitProperties");
   if (UNLIKELY (sd_err < 0))
-    {
-      ret = crun_make_error (err, -sd_err, "set up dbus message");
-      goto exit;
-    }
+    return crun_make_error (err, -sd_err, "set up dbus message");
 
   sd_err = sd_bus_message_append (m, "sb", cgroup_status->scope, 1);
   if (UNLIKELY (sd_err < 0))
@@ -2237,29 +2496,76 @@ libcrun_update_resources_systemd (struct libcrun_cgroup_status *cgroup_status,
       goto exit;
     }
 
-  sd_err = sd_bus_call (bus, m, 0, &error, &reply);
-  if (UNLIKELY (sd_err < 0))
-    {
-      ret = crun_make_error (err, sd_bus_error_get_errno (&error), "sd-bus call: %s", error.message ?: error.name);
-      goto exit;
-    }
+  *out = m;
+  m = NULL;
+  ret = 0;
+
+exit:
+  if (m)
+    sd_bus_message_unref (m);
+  return ret;
+}
+
+/* Configure what systemd does not handle, once the properties are set.  */
+static int
+finish_update_resources_systemd (struct libcrun_cgroup_status *cgroup_status,
+                                 runtime_spec_schema_config_linux_resources *resources,
+                                 int cgroup_mode, libcrun_error_t *err)
+{
+  int ret;
 
   if (cgroup_mode != CGROUP_MODE_UNIFIED)
     {
       ret = setup_rt_runtime (resources, cgroup_status->path, err);
       if (UNLIKELY (ret < 0))
-        goto exit;
+        return ret;
 
       ret = setup_cpuset_for_systemd_v1 (resources, cgroup_status->path, err);
       if (UNLIKELY (ret < 0))
-        goto exit;
+        return ret;
     }
 
-  ret = setup_missing_cpu_options_for_systemd (resources, cgroup_mode == CGROUP_MODE_UNIFIED, cgroup_status->path, err);
+  return setup_missing_cpu_options_for_systemd (resources, cgroup_mode == CGROUP_MODE_UNIFIED, cgroup_status->path, err);
+}
+
+static int
+libcrun_update_resources_systemd (struct libcrun_cgroup_status *cgroup_status,
+                                  const char *state_root,
+                                  runtime_spec_schema_config_linux_resources *resources,
+                                  libcrun_error_t *err)
+{
+  sd_bus_error error = SD_BUS_ERROR_NULL;
+  cleanup_free char *state_dir = NULL;
+  sd_bus_message *reply = NULL;
+  sd_bus_message *m = NULL;
+  sd_bus *bus = NULL;
+  int sd_err, ret;
+  int cgroup_mode;
+
+  ret = libcrun_get_state_directory (&state_dir, state_root, NULL, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  cgroup_mode = libcrun_get_cgroup_mode (err);
+  if (UNLIKELY (cgroup_mode < 0))
+    return cgroup_mode;
+
+  ret = open_sd_bus_connection (&bus, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = make_set_unit_properties_message (bus, &m, cgroup_status, state_dir, resources, cgroup_mode, err);
   if (UNLIKELY (ret < 0))
     goto exit;
 
-  ret = 0;
+  sd_err = sd_bus_call (bus, m, 0, &error, &reply);
+  if (UNLIKELY (sd_err < 0))
+    {
+      ret = crun_make_error (err, sd_bus_error_get_errno (&error), "sd-bus call: %s", error.message ?: error.name);
+      goto exit;
+    }
+
+  ret = finish_update_resources_systemd (cgroup_status, resources, cgroup_mode, err);
 
 exit:
   if (bus)
@@ -2272,6 +2578,125 @@ exit:
   return ret;
 }
 
+struct set_unit_properties_call_s
+{
+  sd_bus_slot *slot;
+  sd_bus_error error;
+  bool replied;
+};
+
+static int
+set_unit_properties_reply (sd_bus_message *m, void *userdata, sd_bus_error *ret_error arg_unused)
+{
+  struct set_unit_properties_call_s *call = userdata;
+
+  call->replied = true;
+  if (sd_bus_message_is_method_error (m, NULL))
+    sd_bus_error_copy (&call->error, sd_bus_message_get_error (m));
+  return 0;
+}
+
+/* Send all the SetUnitProperties calls before waiting for any reply, so
+   that updating N scopes costs one round trip instead of N.  */
+static int
+libcrun_update_resources_many_systemd (struct libcrun_cgroup_status **cgroup_status,
+                                       const char *state_root,
+                                       runtime_spec_schema_config_linux_resources **resources,
+                                       size_t n,
+                                       libcrun_error_t *err)
+{
+  cleanup_free struct set_unit_properties_call_s *calls = NULL;
+  cleanup_free char *state_dir = NULL;
+  size_t i, sent = 0, replied = 0;
+  sd_bus *bus = NULL;
+  int sd_err, ret;
+  int cgroup_mode;
+
+  ret = libcrun_get_state_directory (&state_dir, state_root, NULL, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  cgroup_mode = libcrun_get_cgroup_mode (err);
+  if (UNLIKELY (cgroup_mode < 0))
+    return cgroup_mode;
+
+  ret = open_sd_bus_connection (&bus, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  calls = xmalloc0 (sizeof (*calls) * (n + 1));
+
+  for (sent = 0; sent < n; sent++)
+    {
+      sd_bus_message *m = NULL;
+
+      calls[sent].error = SD_BUS_ERROR_NULL;
+
+      ret = make_set_unit_properties_message (bus, &m, cgroup_status[sent], state_dir, resources[sent], cgroup_mode,
+                                              err);
+      if (UNLIKELY (ret < 0))
+        goto exit;
+
+      sd_err = sd_bus_call_async (bus, &calls[sent].slot, m, set_unit_properties_reply, &calls[sent], 0);
+      sd_bus_message_unref (m);
+      if (UNLIKELY (sd_err < 0))
+        {
+          ret = crun_make_error (err, -sd_err, "sd-bus call async");
+          goto exit;
+        }
+    }
+
+  while (replied < n)
+    {
+      sd_err = sd_bus_process (bus, NULL);
+      if (UNLIKELY (sd_err < 0))
+        {
+          ret = crun_make_error (err, -sd_err, "sd-bus process");
+          goto exit;
+        }
+
+      if (sd_err == 0)
+        {
+          sd_err = sd_bus_wait (bus, (uint64_t) -1);
+          if (UNLIKELY (sd_err < 0))
+            {
+              ret = crun_make_error (err, -sd_err, "sd-bus wait");
+              goto exit;
+            }
+        }
+
+      for (replied = 0; replied < n && calls[replied].replied; replied++)
+        ;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      if (sd_bus_error_is_set (&calls[i].error))
+        {
+          ret = crun_make_error (err, sd_bus_error_get_errno (&calls[i].error), "sd-bus call `%s`: %s",
+                                 cgroup_status[i]->scope, calls[i].error.message ?: calls[i].error.name);
+          goto exit;
+        }
+
+      ret = finish_update_resources_systemd (cgroup_status[i], resources[i], cgroup_mode, err);
+      if (UNLIKELY (ret < 0))
+        goto exit;
+    }
+
+  ret = 0;
+
+exit:
+  for (i = 0; i < sent; i++)
+    {
+      if (calls[i].slot)
+        sd_bus_slot_unref (calls[i].slot);
+      sd_bus_error_free (&calls[i].error);
+    }
+  if (bus)
+    sd_bus_unref (bus);
+  return ret;
+}
+
 #else
 static int
 libcrun_cgroup_enter_systemd (struct libcrun_cgroup_args *args,
@@ -2305,6 +2730,37 @@ libcrun_update_resources_systemd (struct libcrun_cgroup_status *cgroup_status,
 
   return crun_make_error (err, ENOTSUP, "systemd not supported");
 }
+
+static int
+libcrun_cgroup_join_systemd (struct libcrun_cgroup_args *args,
+                             struct libcrun_cgroup_status *out,
+                             libcrun_error_t *err)
+{
+  (void) args;
+  (void) out;
+
+  return crun_make_error (err, ENOTSUP, "systemd not supported");
+}
+
+static int
+libcrun_update_resources_many_systemd (struct libcrun_cgroup_status **cgroup_status,
+                                       const char *state_root,
+                                       runtime_spec_schema_config_linux_resources **resources,
+                                       size_t n,
+                                       libcrun_error_t *err)
+{
+  (void) cgroup_status;
+  (void) state_root;
+  (void) resources;
+  (void) n;
+
+  return crun_make_error (err, ENOTSUP, "systemd not supported");
+}
+
+static void
+free_systemd_pending_scope (void *data arg_unused)
+{
+}
 #endif
 
 struct libcrun_cgroup_manager cgroup_manager_systemd = {
@@ -2312,4 +2768,7 @@ struct libcrun_cgroup_manager cgroup_manager_systemd = {
   .create_cgroup = libcrun_cgroup_enter_systemd,
   .destroy_cgroup = libcrun_destroy_cgroup_systemd,
   .update_resources = libcrun_update_resources_systemd,
+  .update_resources_many = libcrun_update_resources_many_systemd,
+  .join_cgroup = libcrun_cgroup_join_systemd,
+  .free_pending = free_systemd_pending_scope,
 };
@@ -38,6 +38,7 @@
 #include <sys/types.h>
 #include <fcntl.h>
 #include <libgen.h>
+#include <poll.h>
 
 struct symlink_s
 {
@@ -489,6 +490,147 @@ read_proc_cgroup (char *content, char **saveptr, char **id, char **controller_li
   return true;
 }
 
+/* Remove all the sub-cgroups under DFD, deepest first.  They must be
+   already empty.  */
+static int
+rmdir_children_at (int dfd, const char *path, libcrun_error_t *err)
+{
+  cleanup_dir DIR *dir = NULL;
+  struct dirent *de;
+  int fd;
+
+  fd = dup (dfd);
+  if (UNLIKELY (fd < 0))
+    return crun_make_error (err, errno, "dup `%s`", path);
+
+  dir = fdopendir (fd);
+  if (UNLIKELY (dir == NULL))
+    {
+      close (fd);
+      return crun_make_error (err, errno, "opendir `%s`", path);
+    }
+
+  for (de = readdir (dir); de; de = readdir (dir))
+    {
+      cleanup_close int child_dfd = -1;
+      int ret;
+
+      if (de->d_type != DT_DIR || strcmp (de->d_name, ".") == 0 || strcmp (de->d_name, "..") == 0)
+        continue;
+
+      child_dfd = openat (dfd, de->d_name, O_DIRECTORY | O_CLOEXEC);
+      if (UNLIKELY (child_dfd < 0))
+        {
+          if (errno == ENOENT)
+            continue;
+          return crun_make_error (err, errno, "open `%s/%s`", path, de->d_name);
+        }
+
+      ret = rmdir_children_at (child_dfd, de->d_name, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      ret = unlinkat (dfd, de->d_name, AT_REMOVEDIR);
+      if (UNLIKELY (ret < 0 && errno != ENOENT))
+        return crun_make_error (err, errno, "rmdir `%s/%s`", path, de->d_name);
+    }
+
+  return 0;
+}
+
+/* Wait until the cgroup at DFD and its descendants have no processes.
+   kernfs notifies changes to cgroup.events with POLLPRI.  */
+static int
+wait_cgroup_unpopulated (int dfd, const char *path, int timeout, libcrun_error_t *err)
+{
+  cleanup_close int events_fd = -1;
+  struct timespec start, now;
+  char buffer[256];
+
+  events_fd = openat (dfd, "cgroup.events", O_RDONLY | O_CLOEXEC);
+  if (UNLIKELY (events_fd < 0))
+    return crun_make_error (err, errno, "open `%s/cgroup.events`", path);
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
+  for (;;)
+    {
+      struct pollfd pfd = { .fd = events_fd, .events = POLLPRI };
+      ssize_t len;
+      int elapsed;
+      int ret;
+
+      /* Reading the file also re-arms the notification.  */
+      len = TEMP_FAILURE_RETRY (pread (events_fd, buffer, sizeof (buffer) - 1, 0));
+      if (UNLIKELY (len < 0))
+        return crun_make_error (err, errno, "read `%s/cgroup.events`", path);
+      buffer[len] = '\0';
+
+      if (strstr (buffer, "populated 0"))
+        return 0;
+
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+      if (elapsed >= timeout)
+        return crun_make_error (err, EBUSY, "timeout waiting for the processes in `%s` to exit", path);
+
+      ret = poll (&pfd, 1, timeout - elapsed);
+      if (UNLIKELY (ret < 0 && errno != EINTR))
+        return crun_make_error (err, errno, "poll `%s/cgroup.events`", path);
+    }
+}
+
+/* Kill everything in the cgroup with cgroup.kill and remove it as soon as
+   it is empty.  Returns 1 if cgroup.kill is not supported by the kernel.  */
+static int
+destroy_cgroup_path_unified (const char *path, libcrun_error_t *err)
+{
+  cleanup_free char *cgroup_path = NULL;
+  cleanup_close int dfd = -1;
+  int ret;
+
+  ret = append_paths (&cgroup_path, err, CGROUP_ROOT, path, NULL);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = rmdir (cgroup_path);
+  if (ret == 0 || errno != EBUSY)
+    return 0;
+
+  dfd = open (cgroup_path, O_DIRECTORY | O_CLOEXEC);
+  if (UNLIKELY (dfd < 0))
+    {
+      if (errno == ENOENT)
+        return 0;
+      return crun_make_error (err, errno, "open `%s`", cgroup_path);
+    }
+
+  ret = write_file_at_with_flags (dfd, 0, 0700, "cgroup.kill", "1", 1, err);
+  if (UNLIKELY (ret < 0))
+    {
+      if (crun_error_get_errno (err) == ENOENT)
+        {
+          crun_error_release (err);
+          return 1;
+        }
+      return ret;
+    }
+
+  ret = wait_cgroup_unpopulated (dfd, cgroup_path, 5000, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = rmdir_children_at (dfd, cgroup_path, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = rmdir (cgroup_path);
+  if (UNLIKELY (ret < 0 && errno != ENOENT))
+    return crun_make_error (err, errno, "cannot delete path `%s`", cgroup_path);
+
+  return 0;
+}
+
 int
 destroy_cgroup_path (const char *path, int mode, libcrun_error_t *err)
 {
@@ -497,6 +639,15 @@ destroy_cgroup_path (const char *path, int mode, libcrun_error_t *err)
   const int max_attempts = 500;
   int ret;
 
+  if (mode == CGROUP_MODE_UNIFIED)
+    {
+      ret = destroy_cgroup_path_unified (path, err);
+      if (ret <= 0)
+        return ret;
+
+      /* Older kernels: kill and retry until the cgroup can be removed.  */
+    }
+
   do
     {
       repeat = false;
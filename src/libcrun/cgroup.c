@@ -230,6 +230,61 @@ libcrun_update_cgroup_resources (struct libcrun_cgroup_status *cgroup_status,
   return update_cgroup_resources (cgroup_status->path, state_root, resources, ! cgroup_status->bpf_dev_set, err);
 }
 
+int
+libcrun_update_cgroup_resources_many (struct libcrun_cgroup_status **cgroup_status,
+                                      const char *state_root,
+                                      runtime_spec_schema_config_linux_resources **resources,
+                                      size_t n,
+                                      libcrun_error_t *err)
+{
+  cleanup_free struct libcrun_cgroup_status **batch_status = xmalloc0 (sizeof (*batch_status) * (n + 1));
+  cleanup_free runtime_spec_schema_config_linux_resources **batch_resources = xmalloc0 (sizeof (*batch_resources) * (n + 1));
+  struct libcrun_cgroup_manager *batch_manager = NULL;
+  size_t i, batch_len = 0;
+  int ret;
+
+  /* Collect the cgroups whose manager can update them together.  */
+  for (i = 0; i < n; i++)
+    {
+      struct libcrun_cgroup_manager *cgroup_manager = NULL;
+
+      ret = get_cgroup_manager (cgroup_status[i]->manager, &cgroup_manager, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      if (cgroup_manager->update_resources_many && (batch_manager == NULL || batch_manager == cgroup_manager))
+        {
+          batch_manager = cgroup_manager;
+          batch_status[batch_len] = cgroup_status[i];
+          batch_resources[batch_len++] = resources[i];
+          continue;
+        }
+
+      if (cgroup_manager->update_resources)
+        {
+          ret = cgroup_manager->update_resources (cgroup_status[i], state_root, resources[i], err);
+          if (UNLIKELY (ret < 0))
+            return ret;
+        }
+    }
+
+  if (batch_len > 0)
+    {
+      ret = batch_manager->update_resources_many (batch_status, state_root, batch_resources, batch_len, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      ret = update_cgroup_resources (cgroup_status[i]->path, state_root, resources[i], ! cgroup_status[i]->bpf_dev_set, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+    }
+
+  return 0;
+}
+
 static int
 can_ignore_cgroup_enter_errors (struct libcrun_cgroup_args *args, int cgroup_mode,
                                 libcrun_error_t *err)
@@ -285,42 +340,13 @@ libcrun_cgroup_preenter (struct libcrun_cgroup_args *args, int *dirfd, libcrun_e
   return cgroup_manager->precreate_cgroup (args, dirfd, err);
 }
 
-int
-libcrun_cgroup_enter (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status **out, libcrun_error_t *err)
+static int
+complete_cgroup_enter (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status *status, int cgroup_mode,
+                       int ret, libcrun_error_t *err)
 {
-  /* status will be filled by the cgroup manager.  */
-  cleanup_cgroup_status struct libcrun_cgroup_status *status = xmalloc0 (sizeof *status);
-  struct libcrun_cgroup_manager *cgroup_manager;
   uid_t root_uid = args->root_uid;
   uid_t root_gid = args->root_gid;
-  int cgroup_mode;
-  int ret;
-
-  cgroup_mode = libcrun_get_cgroup_mode (err);
-  if (UNLIKELY (cgroup_mode < 0))
-    return cgroup_mode;
-
-  if (cgroup_mode == CGROUP_MODE_HYBRID)
-    {
-      /* We don't really support hybrid mode, so check that cgroups2 is not using any controller.  */
-
-      size_t len;
-      cleanup_free char *buffer = NULL;
-
-      ret = read_all_file (CGROUP_ROOT "/unified/cgroup.controllers", &buffer, &len, err);
-      if (UNLIKELY (ret < 0))
-        return ret;
-      if (len > 0)
-        return crun_make_error (err, 0, "cgroups in hybrid mode not supported, drop all controllers from cgroupv2");
-    }
 
-  ret = get_cgroup_manager (args->manager, &cgroup_manager, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
-
-  status->manager = args->manager;
-
-  ret = cgroup_manager->create_cgroup (args, status, err);
   if (UNLIKELY (ret < 0))
     {
       libcrun_error_t tmp_err = NULL;
@@ -344,7 +370,7 @@ libcrun_cgroup_enter (struct libcrun_cgroup_args *args, struct libcrun_cgroup_st
           status->manager = CGROUP_MANAGER_DISABLED;
           crun_error_release (err);
 
-          goto success;
+          return 0;
         }
 
       return ret;
@@ -369,12 +395,84 @@ libcrun_cgroup_enter (struct libcrun_cgroup_args *args, struct libcrun_cgroup_st
             return ret;
         }
     }
-success:
+  return 0;
+}
+
+int
+libcrun_cgroup_enter (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status **out, libcrun_error_t *err)
+{
+  /* status will be filled by the cgroup manager.  */
+  cleanup_cgroup_status struct libcrun_cgroup_status *status = xmalloc0 (sizeof *status);
+  struct libcrun_cgroup_manager *cgroup_manager;
+  int cgroup_mode;
+  int ret;
+
+  cgroup_mode = libcrun_get_cgroup_mode (err);
+  if (UNLIKELY (cgroup_mode < 0))
+    return cgroup_mode;
+
+  if (cgroup_mode == CGROUP_MODE_HYBRID)
+    {
+      /* We don't really support hybrid mode, so check that cgroups2 is not using any controller.  */
+
+      size_t len;
+      cleanup_free char *buffer = NULL;
+
+      ret = read_all_file (CGROUP_ROOT "/unified/cgroup.controllers", &buffer, &len, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+      if (len > 0)
+        return crun_make_error (err, 0, "cgroups in hybrid mode not supported, drop all controllers from cgroupv2");
+    }
+
+  ret = get_cgroup_manager (args->manager, &cgroup_manager, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  status->manager = args->manager;
+
+  ret = cgroup_manager->create_cgroup (args, status, err);
+
+  /* The manager has not finished yet, the rest is done once joined.  */
+  if (LIKELY (ret >= 0) && status->pending)
+    goto exit;
+
+  ret = complete_cgroup_enter (args, status, cgroup_mode, ret, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+exit:
   *out = status;
   status = NULL;
   return 0;
 }
 
+int
+libcrun_cgroup_enter_join (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status *status,
+                           libcrun_error_t *err)
+{
+  struct libcrun_cgroup_manager *cgroup_manager;
+  int cgroup_mode;
+  int ret;
+
+  if (status == NULL || status->pending == NULL)
+    return 0;
+
+  cgroup_mode = libcrun_get_cgroup_mode (err);
+  if (UNLIKELY (cgroup_mode < 0))
+    return cgroup_mode;
+
+  ret = get_cgroup_manager (status->manager, &cgroup_manager, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  /* join_cgroup takes ownership of the pending state.  */
+  ret = cgroup_manager->join_cgroup (args, status, err);
+
+  /* On errors the status is kept, the scope may exist already.  */
+  return complete_cgroup_enter (args, status, cgroup_mode, ret, err);
+}
+
 int
 libcrun_cgroup_enter_finalize (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status *cgroup_status arg_unused, libcrun_error_t *err)
 {
@@ -543,6 +641,16 @@ libcrun_cgroup_status_free (struct libcrun_cgroup_status *cgroup_status)
   if (cgroup_status == NULL)
     return;
 
+  if (cgroup_status->pending)
+    {
+      struct libcrun_cgroup_manager *cgroup_manager;
+      libcrun_error_t tmp_err = NULL;
+
+      if (get_cgroup_manager (cgroup_status->manager, &cgroup_manager, &tmp_err) == 0)
+        cgroup_manager->free_pending (cgroup_status->pending);
+      crun_error_release (&tmp_err);
+    }
+
   free (cgroup_status->path);
   free (cgroup_status->scope);
   free (cgroup_status);
@@ -58,6 +58,10 @@ struct libcrun_cgroup_args
   const char *id;
   bool joined;
 
+  /* The caller supports libcrun_cgroup_enter_join, so the manager can
+     return before the cgroup is ready.  */
+  bool async;
+
   const char *state_root;
   libcrun_container_t *container;
 };
@@ -65,6 +69,10 @@ struct libcrun_cgroup_args
 /* cgroup life-cycle management.  */
 int libcrun_cgroup_preenter (struct libcrun_cgroup_args *args, int *dirfd, libcrun_error_t *err);
 int libcrun_cgroup_enter (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status **out, libcrun_error_t *err);
+/* Wait for a cgroup entered with ARGS->async set.  Unlike
+   libcrun_cgroup_enter, CGROUP_STATUS is kept on errors so that the
+   cgroup can still be destroyed.  */
+int libcrun_cgroup_enter_join (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status *cgroup_status, libcrun_error_t *err);
 int libcrun_cgroup_enter_finalize (struct libcrun_cgroup_args *args, struct libcrun_cgroup_status *cgroup_status, libcrun_error_t *err);
 int libcrun_cgroup_destroy (struct libcrun_cgroup_status *cgroup_status, libcrun_error_t *err);
 
@@ -97,6 +105,12 @@ int libcrun_update_cgroup_resources (struct libcrun_cgroup_status *status,
                                      runtime_spec_schema_config_linux_resources *resources,
                                      libcrun_error_t *err);
 
+int libcrun_update_cgroup_resources_many (struct libcrun_cgroup_status **status,
+                                          const char *state_root,
+                                          runtime_spec_schema_config_linux_resources **resources,
+                                          size_t n,
+                                          libcrun_error_t *err);
+
 int libcrun_cgroup_is_container_paused (struct libcrun_cgroup_status *status, bool *paused, libcrun_error_t *err);
 
 int libcrun_cgroup_pause_unpause (struct libcrun_cgroup_status *status, const bool pause, libcrun_error_t *err);
@@ -516,7 +516,7 @@ static int clone_binary(void)
 		}
 		sent += n;
 	}
-	close(binfd);
+	close_and_reset(&binfd);
 	if (sent != statbuf.st_size)
 		goto error;
 
@@ -46,6 +46,9 @@
 #include "io_priority.h"
 #include "cgroup.h"
 #include "cgroup-utils.h"
+#include "cgroup-stats.h"
+#include "trace.h"
+#include "annotations.h"
 #include <sys/prctl.h>
 #include <sys/signalfd.h>
 #include <sys/epoll.h>
@@ -54,6 +57,7 @@
 #  include <sys/capability.h>
 #endif
 #include <sys/ioctl.h>
+#include <time.h>
 #include <termios.h>
 #include <grp.h>
 #include <libgen.h>
@@ -68,12 +72,16 @@
 
 #define YAJL_STR(x) ((const unsigned char *) (x))
 
+/* Reduced configuration used by exec, written next to config.json.  */
+#define EXEC_CONFIG_FILE "exec.json"
+
 enum
 {
   SYNC_SOCKET_SYNC_MESSAGE,
   SYNC_SOCKET_ERROR_MESSAGE,
   SYNC_SOCKET_WARNING_MESSAGE,
   SYNC_SOCKET_DEBUG_MESSAGE,
+  SYNC_SOCKET_TRACE_MESSAGE,
 };
 
 struct container_entrypoint_s
@@ -423,6 +431,28 @@ sync_socket_write_msg (int fd, int verbosity, int err_value, const char *log_msg
   return 0;
 }
 
+/* Send a trace event recorded by the container init to the runtime.  */
+static int
+sync_socket_write_trace (const char *name, char phase, unsigned long long ts, void *arg)
+{
+  struct sync_socket_message_s msg = {
+    0,
+  };
+  int fd = *((int *) arg);
+  int len, ret;
+
+  msg.type = SYNC_SOCKET_TRACE_MESSAGE;
+  len = snprintf (msg.message, sizeof (msg.message), "%c %llu %s", phase, ts, name);
+  if (UNLIKELY (len >= (int) sizeof (msg.message)))
+    return 0;
+
+  ret = TEMP_FAILURE_RETRY (write (fd, &msg, SYNC_SOCKET_MESSAGE_LEN (msg, len + 1)));
+  if (UNLIKELY (ret < 0))
+    return -1;
+
+  return 0;
+}
+
 static int
 sync_socket_write_error (int fd, libcrun_error_t *out_err)
 {
@@ -520,6 +550,16 @@ sync_socket_wait_sync (libcrun_context_t *context, int fd, bool flush, libcrun_e
             context->output_handler (msg.error_value, msg.message, LIBCRUN_VERBOSITY_WARNING, context->output_handler_arg);
           continue;
         }
+      else if (msg.type == SYNC_SOCKET_TRACE_MESSAGE)
+        {
+          unsigned long long ts;
+          char phase;
+          int name_offset = 0;
+
+          if (sscanf (msg.message, "%c %llu %n", &phase, &ts, &name_offset) >= 2 && name_offset > 0)
+            libcrun_trace_add_event (msg.message + name_offset, phase, ts, LIBCRUN_TRACE_INIT);
+          continue;
+        }
       else if (msg.type == SYNC_SOCKET_ERROR_MESSAGE)
         return crun_make_error (err, msg.error_value, "%s", msg.message);
     }
@@ -565,6 +605,7 @@ make_container (runtime_spec_schema_config_schema *container_def, const char *pa
   container->proc_fd = -1;
 
   container->annotations = make_string_map_from_json (container_def->annotations);
+  container->run_oci_annotations = run_oci_annotations_index (container_def->annotations);
 
   if (path)
     container->config_file = xstrdup (path);
@@ -616,6 +657,7 @@ libcrun_container_free (libcrun_container_t *ctr)
     free_runtime_spec_schema_config_schema (ctr->container_def);
 
   free_string_map (ctr->annotations);
+  run_oci_annotations_free (ctr->run_oci_annotations);
 
   if (ctr->proc_fd >= 0)
     close (ctr->proc_fd);
@@ -688,17 +730,83 @@ initialize_security (libcrun_container_t *container, runtime_spec_schema_config_
   return 0;
 }
 
+/* Check whether the hooks for STAGE are listed in the run.oci.hooks.parallel
+   annotation.  */
+static bool
+hooks_stage_is_parallel (libcrun_container_t *container, const char *stage)
+{
+  size_t stage_len = strlen (stage);
+  const char *it;
+
+  it = find_run_oci_annotation (container, RUN_OCI_HOOKS_PARALLEL);
+  if (it == NULL)
+    return false;
+
+  for (; *it; it += strcspn (it, ","), it += (*it == ',') ? 1 : 0)
+    if (strncmp (it, stage, stage_len) == 0 && (it[stage_len] == ',' || it[stage_len] == '\0'))
+      return true;
+
+  return false;
+}
+
+static int
+run_hooks_parallel (hook **hooks, size_t hooks_len, bool keep_going, const char *cwd, char *stdin,
+                    size_t stdin_len, int out_fd, int err_fd, libcrun_error_t *err)
+{
+  cleanup_free struct run_process_s *processes = xmalloc0 (sizeof (*processes) * hooks_len);
+  size_t i;
+  int ret;
+
+  for (i = 0; i < hooks_len; i++)
+    {
+      processes[i].path = hooks[i]->path;
+      processes[i].args = hooks[i]->args;
+      processes[i].envp = hooks[i]->env ? hooks[i]->env : environ;
+      processes[i].timeout = hooks[i]->timeout;
+    }
+
+  ret = run_processes_with_stdin_timeout (processes, hooks_len, cwd, stdin, stdin_len, out_fd, err_fd, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  /* Report the failures in the order the hooks are listed, as if they ran
+     one after the other.  */
+  for (i = 0; i < hooks_len; i++)
+    {
+      if (processes[i].exit_code == 0)
+        continue;
+
+      if (processes[i].timed_out && ! keep_going)
+        return crun_make_error (err, 0, "timeout expired for `%s`", hooks[i]->path);
+
+      ret = processes[i].exit_code;
+      if (keep_going)
+        libcrun_warning ("error executing hook `%s` (exit code: %d)", hooks[i]->path, ret);
+      else
+        {
+          libcrun_error (0, "error executing hook `%s` (exit code: %d)", hooks[i]->path, ret);
+          return ret;
+        }
+    }
+  return ret;
+}
+
 static int
-do_hooks (runtime_spec_schema_config_schema *def, pid_t pid, const char *id, bool keep_going, const char *cwd,
-          const char *status, hook **hooks, size_t hooks_len, int out_fd, int err_fd, libcrun_error_t *err)
+do_hooks (libcrun_container_t *container, pid_t pid, const char *id, bool keep_going, const char *cwd,
+          const char *status, const char *stage, hook **hooks, size_t hooks_len, int out_fd, int err_fd,
+          libcrun_error_t *err)
 {
+  runtime_spec_schema_config_schema *def = container->container_def;
   size_t i, stdin_len;
   int r, ret;
   char *stdin = NULL;
   cleanup_free char *cwd_allocated = NULL;
   const char *rootfs = def->root ? def->root->path : "";
+  struct timespec start, end;
   yajl_gen gen = NULL;
 
+  clock_gettime (CLOCK_MONOTONIC, &start);
+
   if (cwd == NULL)
     {
       cwd = cwd_allocated = getcwd (NULL, 0);
@@ -800,6 +908,14 @@ do_hooks (runtime_spec_schema_config_schema *def, pid_t pid, const char *id, boo
 
   ret = 0;
 
+  libcrun_trace_begin (stage);
+
+  if (hooks_len > 1 && hooks_stage_is_parallel (container, stage))
+    {
+      ret = run_hooks_parallel (hooks, hooks_len, keep_going, cwd, stdin, stdin_len, out_fd, err_fd, err);
+      goto exit;
+    }
+
   for (i = 0; i < hooks_len; i++)
     {
       char **env = environ;
@@ -821,6 +937,12 @@ do_hooks (runtime_spec_schema_config_schema *def, pid_t pid, const char *id, boo
         }
     }
 
+exit:
+  libcrun_trace_end (stage);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  libcrun_debug ("Running `%s` hooks took %lld us", stage,
+                 (long long) (end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_nsec - start.tv_nsec) / 1000);
+
   if (gen)
     yajl_gen_free (gen);
 
@@ -1310,9 +1432,11 @@ container_init_setup (void *args, pid_t own_pid, char *notify_socket,
   if (UNLIKELY (ret < 0))
     return ret;
 
+  libcrun_trace_begin ("configure_network");
   ret = libcrun_configure_network (container, err);
   if (UNLIKELY (ret < 0))
     return ret;
+  libcrun_trace_end ("configure_network");
 
   ret = resolve_rootfs_path (container, &rootfs, err);
   if (UNLIKELY (ret < 0))
@@ -1340,15 +1464,17 @@ container_init_setup (void *args, pid_t own_pid, char *notify_socket,
     return ret;
 
   /* sync 2 and 3 are sent as part of libcrun_set_mounts.  */
+  libcrun_trace_begin ("set_mounts");
   ret = libcrun_set_mounts (entrypoint_args, container, rootfs, send_sync_cb, &sync_socket, err);
   if (UNLIKELY (ret < 0))
     return ret;
+  libcrun_trace_end ("set_mounts");
 
   if (def->hooks && def->hooks->create_container_len)
     {
-      ret = do_hooks (def, 0, container->context->id, false, NULL, "created", (hook **) def->hooks->create_container,
-                      def->hooks->create_container_len, entrypoint_args->hooks_out_fd, entrypoint_args->hooks_err_fd,
-                      err);
+      ret = do_hooks (container, 0, container->context->id, false, NULL, "created", "createContainer",
+                      (hook **) def->hooks->create_container, def->hooks->create_container_len,
+                      entrypoint_args->hooks_out_fd, entrypoint_args->hooks_err_fd, err);
       if (UNLIKELY (ret != 0))
         return ret;
     }
@@ -1370,9 +1496,11 @@ container_init_setup (void *args, pid_t own_pid, char *notify_socket,
 
   if (rootfs)
     {
+      libcrun_trace_begin ("pivot_root");
       ret = libcrun_do_pivot_root (container, entrypoint_args->context->no_pivot, rootfs, err);
       if (UNLIKELY (ret < 0))
         return ret;
+      libcrun_trace_end ("pivot_root");
     }
 
   ret = libcrun_reopen_dev_null (err);
@@ -1478,7 +1606,7 @@ open_hooks_output (libcrun_container_t *container, int *out_fd, int *err_fd, lib
   *err_fd = *out_fd = -1;
 
   libcrun_debug ("Opening hooks output");
-  annotation = find_annotation (container, "run.oci.hooks.stdout");
+  annotation = find_run_oci_annotation (container, RUN_OCI_HOOKS_STDOUT);
   if (annotation)
     {
       libcrun_debug ("Found `run.oci.hooks.stdout` annotation");
@@ -1487,7 +1615,7 @@ open_hooks_output (libcrun_container_t *container, int *out_fd, int *err_fd, lib
         return crun_make_error (err, errno, "open `%s`", annotation);
     }
 
-  annotation = find_annotation (container, "run.oci.hooks.stderr");
+  annotation = find_run_oci_annotation (container, RUN_OCI_HOOKS_STDERR);
   if (annotation)
     {
       libcrun_debug ("Found `run.oci.hooks.stderr` annotation");
@@ -1546,6 +1674,9 @@ container_init (void *args, char *notify_socket, int sync_socket, libcrun_error_
 
   crun_set_output_handler (log_write_to_sync_socket, args);
 
+  /* The events inherited from the runtime are already recorded there.  */
+  libcrun_trace_reset ();
+
   /* sync receive own pid.  */
   ret = TEMP_FAILURE_RETRY (read (sync_socket, &own_pid, sizeof (own_pid)));
   if (UNLIKELY (ret != sizeof (own_pid)))
@@ -1555,6 +1686,7 @@ container_init (void *args, char *notify_socket, int sync_socket, libcrun_error_
       return crun_make_error (err, errno, "read from sync socket");
     }
 
+  libcrun_trace_begin ("container_init_setup");
   ret = container_init_setup (args, own_pid, notify_socket, sync_socket, &exec_path, err);
   if (UNLIKELY (ret < 0))
     {
@@ -1567,12 +1699,21 @@ container_init (void *args, char *notify_socket, int sync_socket, libcrun_error_
       return ret;
     }
 
+  libcrun_trace_end ("container_init_setup");
+
   entrypoint_args->sync_socket = -1;
 
   ret = unblock_signals (err);
   if (UNLIKELY (ret < 0))
     return ret;
 
+  if (libcrun_trace_enabled ())
+    {
+      ret = libcrun_trace_foreach (sync_socket_write_trace, &sync_socket);
+      if (UNLIKELY (ret < 0))
+        return crun_make_error (err, errno, "write to sync socket");
+    }
+
   /* sync 4.  */
   ret = sync_socket_send_sync (sync_socket, false, err);
   if (UNLIKELY (ret < 0))
@@ -1644,9 +1785,9 @@ container_init (void *args, char *notify_socket, int sync_socket, libcrun_error_
     {
       libcrun_container_t *container = entrypoint_args->container;
 
-      ret = do_hooks (def, 0, container->context->id, false, NULL, "starting", (hook **) def->hooks->start_container,
-                      def->hooks->start_container_len, entrypoint_args->hooks_out_fd, entrypoint_args->hooks_err_fd,
-                      err);
+      ret = do_hooks (container, 0, container->context->id, false, NULL, "starting", "startContainer",
+                      (hook **) def->hooks->start_container, def->hooks->start_container_len,
+                      entrypoint_args->hooks_out_fd, entrypoint_args->hooks_err_fd, err);
       if (UNLIKELY (ret != 0))
         return ret;
 
@@ -1775,7 +1916,7 @@ run_poststop_hooks (libcrun_context_t *context, libcrun_container_t *container,
       if (UNLIKELY (ret < 0))
         return ret;
 
-      ret = do_hooks (def, 0, id, true, status->bundle, "stopped", (hook **) def->hooks->poststop,
+      ret = do_hooks (container, 0, id, true, status->bundle, "stopped", "poststop", (hook **) def->hooks->poststop,
                       def->hooks->poststop_len, hooks_out_fd, hooks_err_fd, err);
       if (UNLIKELY (ret < 0))
         crun_error_write_warning_and_release (context->output_handler_arg, &err);
@@ -2070,11 +2211,65 @@ handle_notify_socket (int notify_socketfd, libcrun_error_t *err)
 #endif
 }
 
+/* Default size of the buffer used to relay the terminal data.  */
+#define DEFAULT_RELAY_BUFFER_SIZE (64 * 1024)
+
+/* Used when /proc/sys/fs/pipe-max-size cannot be read, it is the kernel
+   default.  */
+#define FALLBACK_MAX_RELAY_BUFFER_SIZE (1024 * 1024)
+
+static size_t
+get_max_relay_buffer_size ()
+{
+  cleanup_free char *content = NULL;
+  libcrun_error_t tmp_err = NULL;
+  unsigned long long value;
+  char *endptr = NULL;
+  size_t len;
+  int ret;
+
+  ret = read_all_file ("/proc/sys/fs/pipe-max-size", &content, &len, &tmp_err);
+  if (UNLIKELY (ret < 0))
+    {
+      crun_error_release (&tmp_err);
+      return FALLBACK_MAX_RELAY_BUFFER_SIZE;
+    }
+
+  errno = 0;
+  value = strtoull (content, &endptr, 10);
+  if (errno != 0 || endptr == content || value == 0)
+    return FALLBACK_MAX_RELAY_BUFFER_SIZE;
+
+  return value;
+}
+
+static size_t
+get_relay_buffer_size (libcrun_container_t *container)
+{
+  size_t size, max_size;
+
+  /* The value is validated when the container is loaded.  */
+  size = find_run_oci_annotation_number (container, RUN_OCI_TERMINAL_BUFFER_SIZE, DEFAULT_RELAY_BUFFER_SIZE);
+  if (size <= DEFAULT_RELAY_BUFFER_SIZE)
+    return size;
+
+  /* A buffer is allocated for each relay channel, do not let the
+     configuration grow it past what a pipe can hold.  */
+  max_size = get_max_relay_buffer_size ();
+  if (size > max_size)
+    {
+      libcrun_warning ("the value of `run.oci.terminal_buffer_size` is too large, using %zu", max_size);
+      size = max_size;
+    }
+  return size;
+}
+
 struct wait_for_process_args
 {
   pid_t pid;
   libcrun_context_t *context;
   int terminal_fd;
+  size_t relay_buffer_size;
   int notify_socket;
   int *container_ready_fd;
   int seccomp_notify_fd;
@@ -2095,8 +2290,10 @@ wait_for_process (struct wait_for_process_args *args, libcrun_error_t *err)
   sigset_t mask;
   int in_fds[max_events];
   int in_fds_len = 0;
-  int out_fds[max_events];
-  int out_fds_len = 0;
+  int relay_in_fds[3] = { -1, -1, -1 };
+  int relay_out_fds[3] = { -1, -1, -1 };
+  bool to_terminal_pending = false;
+  bool from_terminal_pending = false;
   size_t i;
 
   cleanup_seccomp_notify_context struct seccomp_notify_context_s *seccomp_notify_ctx = NULL;
@@ -2107,10 +2304,7 @@ wait_for_process (struct wait_for_process_args *args, libcrun_error_t *err)
     return crun_make_error (err, 0, "internal error: context is empty");
 
   for (i = 0; i < max_events; i++)
-    {
-      in_fds[i] = -1;
-      out_fds[i] = -1;
-    }
+    in_fds[i] = -1;
 
   if (args->context->pid_file)
     {
@@ -2203,8 +2397,8 @@ wait_for_process (struct wait_for_process_args *args, libcrun_error_t *err)
             return ret;
         }
 
-      from_terminal = channel_fd_pair_new (terminal_fd_from, 1, BUFSIZ);
-      to_terminal = channel_fd_pair_new (0, terminal_fd_to, BUFSIZ);
+      from_terminal = channel_fd_pair_new (terminal_fd_from, 1, args->relay_buffer_size);
+      to_terminal = channel_fd_pair_new (0, terminal_fd_to, args->relay_buffer_size);
     }
 
   in_fds[in_fds_len++] = signalfd;
@@ -2212,14 +2406,16 @@ wait_for_process (struct wait_for_process_args *args, libcrun_error_t *err)
     in_fds[in_fds_len++] = args->notify_socket;
   if (args->terminal_fd >= 0)
     {
-      in_fds[in_fds_len++] = 0;
-      out_fds[out_fds_len++] = terminal_fd_to;
+      /* The relay fds are registered edge-triggered once, the channels
+         drain them so their interest never needs to be changed.  */
+      relay_in_fds[0] = 0;
+      relay_out_fds[0] = terminal_fd_to;
 
-      in_fds[in_fds_len++] = terminal_fd_from;
-      out_fds[out_fds_len++] = 1;
+      relay_in_fds[1] = terminal_fd_from;
+      relay_out_fds[1] = 1;
     }
 
-  epollfd = epoll_helper (in_fds, NULL, out_fds, NULL, err);
+  epollfd = epoll_helper (in_fds, relay_in_fds, NULL, relay_out_fds, err);
   if (UNLIKELY (epollfd < 0))
     return epollfd;
 
@@ -2231,23 +2427,42 @@ wait_for_process (struct wait_for_process_args *args, libcrun_error_t *err)
       int i, nr_events;
       ssize_t res;
 
-      nr_events = TEMP_FAILURE_RETRY (epoll_wait (epollfd, events, max_events, -1));
+      /* Do not block if a channel has still data to move.  */
+      nr_events = TEMP_FAILURE_RETRY (epoll_wait (epollfd, events, max_events,
+                                                  (to_terminal_pending || from_terminal_pending) ? 0 : -1));
       if (UNLIKELY (nr_events < 0))
         return crun_make_error (err, errno, "epoll_wait");
 
+      if (to_terminal_pending)
+        {
+          ret = channel_fd_pair_process (to_terminal, err);
+          if (UNLIKELY (ret < 0))
+            return crun_error_wrap (err, "copy to terminal fd");
+          to_terminal_pending = ret > 0;
+        }
+      if (from_terminal_pending)
+        {
+          ret = channel_fd_pair_process (from_terminal, err);
+          if (UNLIKELY (ret < 0))
+            return crun_error_wrap (err, "copy from terminal fd");
+          from_terminal_pending = ret > 0;
+        }
+
       for (i = 0; i < nr_events; i++)
         {
           if (events[i].data.fd == 0 || events[i].data.fd == terminal_fd_to)
             {
-              ret = channel_fd_pair_process (to_terminal, epollfd, err);
+              ret = channel_fd_pair_process (to_terminal, err);
               if (UNLIKELY (ret < 0))
                 return crun_error_wrap (err, "copy to terminal fd");
+              to_terminal_pending = ret > 0;
             }
           else if (events[i].data.fd == 1 || events[i].data.fd == terminal_fd_from)
             {
-              ret = channel_fd_pair_process (from_terminal, epollfd, err);
+              ret = channel_fd_pair_process (from_terminal, err);
               if (UNLIKELY (ret < 0))
                 return crun_error_wrap (err, "copy from terminal fd");
+              from_terminal_pending = ret > 0;
             }
           else if (events[i].data.fd == args->seccomp_notify_fd)
             {
@@ -2439,7 +2654,7 @@ get_seccomp_receiver_fd (libcrun_container_t *container, int *fd, int *self_rece
   *fd = -1;
   *self_receiver_fd = -1;
 
-  tmp = find_annotation (container, "run.oci.seccomp.plugins");
+  tmp = find_run_oci_annotation (container, RUN_OCI_SECCOMP_PLUGINS);
   if (tmp)
     {
       int fds[2];
@@ -2458,7 +2673,7 @@ get_seccomp_receiver_fd (libcrun_container_t *container, int *fd, int *self_rece
   if (def && def->linux && def->linux->seccomp && def->linux->seccomp->listener_path)
     tmp = def->linux->seccomp->listener_path;
   else
-    tmp = find_annotation (container, "run.oci.seccomp.receiver");
+    tmp = find_run_oci_annotation (container, RUN_OCI_SECCOMP_RECEIVER);
   if (tmp == NULL)
     tmp = getenv ("RUN_OCI_SECCOMP_RECEIVER");
   if (tmp)
@@ -2482,7 +2697,7 @@ has_seccomp_receiver (libcrun_container_t *container)
   if (def && def->linux && def->linux->seccomp && def->linux->seccomp->listener_path)
     return true;
 
-  if (find_annotation (container, "run.oci.seccomp.receiver") != NULL || getenv ("RUN_OCI_SECCOMP_RECEIVER") != NULL)
+  if (find_run_oci_annotation (container, RUN_OCI_SECCOMP_RECEIVER) != NULL || getenv ("RUN_OCI_SECCOMP_RECEIVER") != NULL)
     return true;
 
   return false;
@@ -2557,6 +2772,20 @@ setup_terminal_socket_pair (libcrun_container_t *container, libcrun_context_t *c
   return 0;
 }
 
+static unsigned int
+get_seccomp_gen_options (libcrun_container_t *container, const char *seccomp_bpf_data)
+{
+  unsigned int seccomp_gen_options = 0;
+
+  if (find_run_oci_annotation_bool (container, RUN_OCI_SECCOMP_FAIL_UNKNOWN_SYSCALL, false))
+    seccomp_gen_options = LIBCRUN_SECCOMP_FAIL_UNKNOWN_SYSCALL;
+
+  if (seccomp_bpf_data)
+    seccomp_gen_options |= LIBCRUN_SECCOMP_SKIP_CACHE;
+
+  return seccomp_gen_options;
+}
+
 static int
 setup_seccomp (libcrun_container_t *container, const char *seccomp_bpf_data,
                struct libcrun_seccomp_gen_ctx_s *seccomp_gen_ctx, int *seccomp_fd, libcrun_error_t *err)
@@ -2564,24 +2793,16 @@ setup_seccomp (libcrun_container_t *container, const char *seccomp_bpf_data,
   runtime_spec_schema_config_schema *def = container->container_def;
   int ret;
 
-  if (find_annotation (container, "run.oci.seccomp.plugins") != NULL && has_seccomp_receiver (container))
+  if (find_run_oci_annotation (container, RUN_OCI_SECCOMP_PLUGINS) != NULL && has_seccomp_receiver (container))
     {
       return crun_make_error (err, errno, "seccomp plugins and seccomp receivers cannot be declared at the same time");
     }
 
   if (def->linux && (def->linux->seccomp || seccomp_bpf_data))
     {
-      unsigned int seccomp_gen_options = 0;
-      const char *annotation;
+      unsigned int seccomp_gen_options = get_seccomp_gen_options (container, seccomp_bpf_data);
 
       libcrun_debug ("Initializing seccomp");
-      annotation = find_annotation (container, "run.oci.seccomp_fail_unknown_syscall");
-      if (annotation && strcmp (annotation, "0") != 0)
-        seccomp_gen_options = LIBCRUN_SECCOMP_FAIL_UNKNOWN_SYSCALL;
-
-      if (seccomp_bpf_data)
-        seccomp_gen_options |= LIBCRUN_SECCOMP_SKIP_CACHE;
-
       libcrun_seccomp_gen_ctx_init (seccomp_gen_ctx, container, true, seccomp_gen_options);
 
       ret = libcrun_open_seccomp_bpf (seccomp_gen_ctx, seccomp_fd, err);
@@ -2759,9 +2980,33 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
   cleanup_close int cgroup_dirfd = -1;
   struct libcrun_dirfd_s cgroup_dirfd_s;
   struct libcrun_seccomp_gen_ctx_s seccomp_gen_ctx;
-  const char *seccomp_bpf_data = find_annotation (container, "run.oci.seccomp_bpf_data");
+  const char *seccomp_bpf_data = find_run_oci_annotation (container, RUN_OCI_SECCOMP_BPF_DATA);
+  cleanup_trace_file bool trace_from_annotation = false;
   int cgroup_mode;
 
+  /* --trace has precedence over the annotation.  The annotation cannot
+     choose the path, the trace is written to the state directory.  */
+  if (find_run_oci_annotation_bool (container, RUN_OCI_TRACE, false) && ! libcrun_trace_enabled ())
+    {
+      cleanup_free char *trace_file = NULL;
+      cleanup_free char *dir = NULL;
+
+      ret = libcrun_get_state_directory (&dir, context->state_root, context->id, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      ret = append_paths (&trace_file, err, dir, "trace.json", NULL);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      libcrun_trace_set_container_file (trace_file);
+      trace_from_annotation = true;
+    }
+
+  libcrun_trace_begin ("container_run");
+
+  run_oci_annotations_warn (container->run_oci_annotations);
+
   cgroup_mode = libcrun_get_cgroup_mode (err);
   if (UNLIKELY (cgroup_mode < 0))
     return cgroup_mode;
@@ -2801,9 +3046,11 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
   if (UNLIKELY (ret < 0))
     return ret;
 
+  libcrun_trace_begin ("setup_seccomp");
   ret = setup_seccomp (container, seccomp_bpf_data, &seccomp_gen_ctx, &seccomp_fd, err);
   if (UNLIKELY (ret < 0))
     return ret;
+  libcrun_trace_end ("setup_seccomp");
   container_args.seccomp_fd = seccomp_fd;
 
   if (seccomp_fd >= 0)
@@ -2818,9 +3065,11 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
   if (UNLIKELY (ret < 0))
     return ret;
 
+  libcrun_trace_begin ("setup_cgroup_manager");
   ret = setup_cgroup_manager (context, container, &cg, &cgroup_dirfd, &cgroup_dirfd_s, err);
   if (UNLIKELY (ret < 0))
     return ret;
+  libcrun_trace_end ("setup_cgroup_manager");
 
   ret = libcrun_configure_handler (container_args.context->handler_manager,
                                    container_args.context,
@@ -2841,9 +3090,11 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
         return ret;
     }
 
+  libcrun_trace_begin ("run_linux_container");
   pid = libcrun_run_linux_container (container, container_init, &container_args, &sync_socket, &cgroup_dirfd_s, err);
   if (UNLIKELY (pid < 0))
     return pid;
+  libcrun_trace_end ("run_linux_container");
 
   cg.pid = pid;
   cg.joined = cgroup_dirfd_s.joined;
@@ -2861,17 +3112,31 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
   if (container_args.terminal_socketpair[1] >= 0)
     close_and_reset (&socket_pair_1);
 
+  /* With systemd the scope is created while the network devices are moved,
+     it is joined before the container process is released.  */
+  cg.async = true;
+
+  libcrun_trace_begin ("cgroup_enter");
   ret = libcrun_cgroup_enter (&cg, &cgroup_status, err);
   if (UNLIKELY (ret < 0))
     goto fail;
+  libcrun_trace_end ("cgroup_enter");
 
   ret = libcrun_apply_intelrdt (context->id, container, pid, LIBCRUN_INTELRDT_CREATE_UPDATE_MOVE, err);
   if (UNLIKELY (ret < 0))
     goto fail;
 
+  libcrun_trace_begin ("move_network_devices");
   ret = libcrun_move_network_devices (container, pid, err);
   if (UNLIKELY (ret < 0))
     goto fail;
+  libcrun_trace_end ("move_network_devices");
+
+  libcrun_trace_begin ("cgroup_enter_join");
+  ret = libcrun_cgroup_enter_join (&cg, cgroup_status, err);
+  if (UNLIKELY (ret < 0))
+    goto fail;
+  libcrun_trace_end ("cgroup_enter_join");
 
   /* sync send own pid.  */
   ret = TEMP_FAILURE_RETRY (write (sync_socket, &pid, sizeof (pid)));
@@ -2893,9 +3158,11 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
   if (UNLIKELY (ret < 0))
     goto fail;
 
+  libcrun_trace_begin ("cgroup_enter_finalize");
   ret = libcrun_cgroup_enter_finalize (&cg, cgroup_status, err);
   if (UNLIKELY (ret < 0))
     goto fail;
+  libcrun_trace_end ("cgroup_enter_finalize");
 
   ret = set_scheduler (pid, def, err);
   if (UNLIKELY (ret < 0))
@@ -2906,7 +3173,7 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
   if (def->hooks && def->hooks->prestart_len)
     {
       libcrun_debug ("Running `prestart` hooks");
-      ret = do_hooks (def, pid, context->id, false, NULL, "created", (hook **) def->hooks->prestart,
+      ret = do_hooks (container, pid, context->id, false, NULL, "created", "prestart", (hook **) def->hooks->prestart,
                       def->hooks->prestart_len, hooks_out_fd, hooks_err_fd, err);
       if (UNLIKELY (ret != 0))
         goto fail;
@@ -2914,15 +3181,18 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
   if (def->hooks && def->hooks->create_runtime_len)
     {
       libcrun_debug ("Running `create` hooks");
-      ret = do_hooks (def, pid, context->id, false, NULL, "created", (hook **) def->hooks->create_runtime,
-                      def->hooks->create_runtime_len, hooks_out_fd, hooks_err_fd, err);
+      ret = do_hooks (container, pid, context->id, false, NULL, "created", "createRuntime",
+                      (hook **) def->hooks->create_runtime, def->hooks->create_runtime_len, hooks_out_fd,
+                      hooks_err_fd, err);
       if (UNLIKELY (ret != 0))
         goto fail;
     }
 
+  libcrun_trace_begin ("seccomp_generation");
   ret = seccomp_generation (seccomp_fd, seccomp_bpf_data, &seccomp_gen_ctx, err);
   if (UNLIKELY (ret < 0))
     goto fail;
+  libcrun_trace_end ("seccomp_generation");
   close_and_reset (&seccomp_fd);
 
   /* sync 3.  */
@@ -2949,21 +3219,36 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
     }
 
   libcrun_debug ("Writing container status");
+  libcrun_trace_begin ("write_container_status");
   ret = write_container_status (container, context, pid, cgroup_status, err);
   if (UNLIKELY (ret < 0))
     goto fail;
+  libcrun_trace_end ("write_container_status");
 
   /* Run poststart hooks here only if the container is created using "run".  For create+start, the
      hooks will be executed as part of the start command.  */
   if (context->fifo_exec_wait_fd < 0 && def->hooks && def->hooks->poststart_len)
     {
       libcrun_debug ("Running `poststart` hooks");
-      ret = do_hooks (def, pid, context->id, true, NULL, "running", (hook **) def->hooks->poststart,
+      ret = do_hooks (container, pid, context->id, true, NULL, "running", "poststart", (hook **) def->hooks->poststart,
                       def->hooks->poststart_len, hooks_out_fd, hooks_err_fd, err);
       if (UNLIKELY (ret < 0))
         goto fail;
     }
 
+  libcrun_trace_end ("container_run");
+  if (libcrun_trace_enabled ())
+    {
+      libcrun_error_t tmp_err = NULL;
+
+      ret = libcrun_trace_write (&tmp_err);
+      if (UNLIKELY (ret < 0))
+        {
+          libcrun_warning ("cannot write the trace file: %s", tmp_err->msg);
+          crun_error_release (&tmp_err);
+        }
+    }
+
   /* Let's receive the seccomp notify fd and handle it as part of wait_for_process().  */
   if (own_seccomp_receiver_fd >= 0)
     {
@@ -2985,6 +3270,7 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
       .pid = pid,
       .context = context,
       .terminal_fd = terminal_fd,
+      .relay_buffer_size = get_relay_buffer_size (container),
       .notify_socket = notify_socket,
       .container_ready_fd = container_ready_fd,
       .seccomp_notify_fd = seccomp_notify_fd,
@@ -3002,6 +3288,15 @@ libcrun_container_run_internal (libcrun_container_t *container, libcrun_context_
   return ret;
 
 fail:
+  if (cgroup_status)
+    {
+      libcrun_error_t tmp_err = NULL;
+
+      /* The scope must exist before it can be destroyed.  Whether the
+         join succeeds or not, the status is still valid to destroy it.  */
+      libcrun_cgroup_enter_join (&cg, cgroup_status, &tmp_err);
+      crun_error_release (&tmp_err);
+    }
   ret = cleanup_watch (context, def, cgroup_status, pid, sync_socket, terminal_fd, err);
   if (cgroup_status)
     {
@@ -3028,6 +3323,69 @@ check_config_file (runtime_spec_schema_config_schema *def, libcrun_context_t *co
   return 0;
 }
 
+/* Write a reduced copy of the configuration with only what is needed by
+   exec.  Most of a config.json is usually the seccomp profile, the mounts
+   and the resources, and none of them is used once the container runs:
+   the seccomp filter is already compiled in the state directory and the
+   cgroup is in the status file.  */
+static int
+write_exec_config_file (const char *dir, libcrun_container_t *container, libcrun_error_t *err)
+{
+  runtime_spec_schema_config_schema *def = container->container_def;
+  struct parser_context ctx = { OPT_GEN_SIMPLIFY, NULL };
+  runtime_spec_schema_config_linux_seccomp seccomp;
+  runtime_spec_schema_config_schema exec_def;
+  runtime_spec_schema_config_linux linux_def;
+  cleanup_free char *dest_path = NULL;
+  cleanup_free char *buffer = NULL;
+  parser_error parser_err = NULL;
+  int ret;
+
+  /* Shallow copies, the data is still owned by DEF.  */
+  exec_def = *def;
+  exec_def.mounts = NULL;
+  exec_def.mounts_len = 0;
+  exec_def.hooks = NULL;
+
+  if (def->linux)
+    {
+      linux_def = *def->linux;
+      linux_def.resources = NULL;
+      linux_def.devices = NULL;
+      linux_def.devices_len = 0;
+      linux_def.masked_paths = NULL;
+      linux_def.masked_paths_len = 0;
+      linux_def.readonly_paths = NULL;
+      linux_def.readonly_paths_len = 0;
+      linux_def.sysctl = NULL;
+
+      /* Keep the flags and the listener, they are used by exec.  */
+      if (def->linux->seccomp)
+        {
+          seccomp = *def->linux->seccomp;
+          seccomp.syscalls = NULL;
+          seccomp.syscalls_len = 0;
+          linux_def.seccomp = &seccomp;
+        }
+      exec_def.linux = &linux_def;
+    }
+
+  buffer = runtime_spec_schema_config_schema_generate_json (&exec_def, &ctx, &parser_err);
+  if (UNLIKELY (buffer == NULL))
+    {
+      ret = crun_make_error (err, 0, "cannot generate the exec configuration: `%s`", parser_err);
+      free (parser_err);
+      return ret;
+    }
+
+  ret = append_paths (&dest_path, err, dir, EXEC_CONFIG_FILE, NULL);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  libcrun_debug ("Writing exec config file to: `%s`", dest_path);
+  return write_file (dest_path, buffer, strlen (buffer), err);
+}
+
 static int
 libcrun_copy_config_file (const char *id, const char *state_root, libcrun_container_t *container, libcrun_error_t *err)
 {
@@ -3068,7 +3426,7 @@ libcrun_copy_config_file (const char *id, const char *state_root, libcrun_contai
         return ret;
     }
 
-  return 0;
+  return write_exec_config_file (dir, container, err);
 }
 
 static void
@@ -3381,8 +3739,8 @@ libcrun_container_start (libcrun_context_t *context, const char *id, libcrun_err
       if (UNLIKELY (ret < 0))
         return ret;
 
-      ret = do_hooks (def, status.pid, context->id, true, status.bundle, "running", (hook **) def->hooks->poststart,
-                      def->hooks->poststart_len, hooks_out_fd, hooks_err_fd, err);
+      ret = do_hooks (container, status.pid, context->id, true, status.bundle, "running", "poststart",
+                      (hook **) def->hooks->poststart, def->hooks->poststart_len, hooks_out_fd, hooks_err_fd, err);
       if (UNLIKELY (ret < 0))
         crun_error_release (err);
     }
@@ -3390,9 +3748,11 @@ libcrun_container_start (libcrun_context_t *context, const char *id, libcrun_err
   return 0;
 }
 
-int
-libcrun_get_container_state_string (const char *id, libcrun_container_status_t *status, const char *state_root,
-                                    const char **container_status, int *running, libcrun_error_t *err)
+/* If RUN_DIRFD is not -1, the state directory is looked up relative to it
+   and STATE_ROOT is ignored.  */
+static int
+get_container_state_string (const char *id, libcrun_container_status_t *status, const char *state_root, int run_dirfd,
+                            const char **container_status, int *running, libcrun_error_t *err)
 {
   int ret, has_fifo = 0;
   bool paused = false;
@@ -3404,7 +3764,10 @@ libcrun_get_container_state_string (const char *id, libcrun_container_status_t *
 
   if (*running)
     {
-      ret = libcrun_status_has_read_exec_fifo (state_root, id, err);
+      if (run_dirfd >= 0)
+        ret = libcrun_status_has_read_exec_fifo_at (run_dirfd, id, err);
+      else
+        ret = libcrun_status_has_read_exec_fifo (state_root, id, err);
       if (UNLIKELY (ret < 0))
         return ret;
       has_fifo = ret;
@@ -3450,6 +3813,13 @@ libcrun_get_container_state_string (const char *id, libcrun_container_status_t *
   return 0;
 }
 
+int
+libcrun_get_container_state_string (const char *id, libcrun_container_status_t *status, const char *state_root,
+                                    const char **container_status, int *running, libcrun_error_t *err)
+{
+  return get_container_state_string (id, status, state_root, -1, container_status, running, err);
+}
+
 int
 libcrun_container_state (libcrun_context_t *context, const char *id, FILE *out, libcrun_error_t *err)
 {
@@ -3822,6 +4192,52 @@ exec_process_entrypoint (libcrun_context_t *context,
   libcrun_fail_with_error (errno, "exec");
 }
 
+/* If the new process block doesn't specify a SELinux label, AppArmor profile or user, then
+   use the configuration from the original config file.  */
+static void
+set_exec_process_defaults (libcrun_container_t *container, runtime_spec_schema_config_schema_process *process)
+{
+  if (container->container_def->process == NULL)
+    return;
+
+  if (process->selinux_label == NULL && container->container_def->process->selinux_label)
+    process->selinux_label = xstrdup (container->container_def->process->selinux_label);
+
+  if (process->apparmor_profile == NULL && container->container_def->process->apparmor_profile)
+    process->apparmor_profile = xstrdup (container->container_def->process->apparmor_profile);
+
+  if (process->user == NULL && container->container_def->process->user)
+    {
+      process->user = clone_runtime_spec_schema_config_schema_process_user (container->container_def->process->user);
+      if (process->user == NULL)
+        OOM ();
+    }
+}
+
+static libcrun_container_t *
+load_exec_config_file (const char *dir, libcrun_error_t *err)
+{
+  cleanup_free char *config_file = NULL;
+  int ret;
+
+  ret = append_paths (&config_file, err, dir, EXEC_CONFIG_FILE, NULL);
+  if (UNLIKELY (ret < 0))
+    return NULL;
+
+  /* Containers created by an older version have only config.json.  */
+  if (access (config_file, F_OK) < 0)
+    {
+      free (config_file);
+      config_file = NULL;
+
+      ret = append_paths (&config_file, err, dir, "config.json", NULL);
+      if (UNLIKELY (ret < 0))
+        return NULL;
+    }
+
+  return libcrun_container_load_from_file (config_file, err);
+}
+
 int
 libcrun_container_exec_with_options (libcrun_context_t *context, const char *id,
                                      struct libcrun_container_exec_options_s *opts,
@@ -3836,7 +4252,6 @@ libcrun_container_exec_with_options (libcrun_context_t *context, const char *id,
   cleanup_close int terminal_fd = -1;
   cleanup_close int seccomp_fd = -1;
   cleanup_terminal void *orig_terminal = NULL;
-  cleanup_free char *config_file = NULL;
   cleanup_container libcrun_container_t *container = NULL;
   cleanup_free char *dir = NULL;
   int container_ret_status[2];
@@ -3864,11 +4279,7 @@ libcrun_container_exec_with_options (libcrun_context_t *context, const char *id,
   if (UNLIKELY (ret < 0))
     return ret;
 
-  ret = append_paths (&config_file, err, dir, "config.json", NULL);
-  if (UNLIKELY (ret < 0))
-    return ret;
-
-  container = libcrun_container_load_from_file (config_file, err);
+  container = load_exec_config_file (dir, err);
   if (UNLIKELY (container == NULL))
     return -1;
 
@@ -3967,23 +4378,7 @@ libcrun_container_exec_with_options (libcrun_context_t *context, const char *id,
   pipefd0 = container_ret_status[0];
   pipefd1 = container_ret_status[1];
 
-  /* If the new process block doesn't specify a SELinux label, AppArmor profile or user, then
-     use the configuration from the original config file.  */
-  if (container->container_def->process)
-    {
-      if (process->selinux_label == NULL && container->container_def->process->selinux_label)
-        process->selinux_label = xstrdup (container->container_def->process->selinux_label);
-
-      if (process->apparmor_profile == NULL && container->container_def->process->apparmor_profile)
-        process->apparmor_profile = xstrdup (container->container_def->process->apparmor_profile);
-
-      if (process->user == NULL && container->container_def->process->user)
-        {
-          process->user = clone_runtime_spec_schema_config_schema_process_user (container->container_def->process->user);
-          if (process->user == NULL)
-            OOM ();
-        }
-    }
+  set_exec_process_defaults (container, process);
 
   ret = initialize_security (container, process, err);
   if (UNLIKELY (ret < 0))
@@ -3994,7 +4389,7 @@ libcrun_container_exec_with_options (libcrun_context_t *context, const char *id,
     return crun_make_error (err, errno, "prctl unset dumpable");
 
   pid = libcrun_join_process (context, container, status.pid, &status, opts->cgroup, context->detach,
-                              process, process->terminal ? &terminal_fd : NULL, err);
+                              process, process->terminal ? &terminal_fd : NULL, NULL, err);
   if (UNLIKELY (pid < 0))
     return pid;
 
@@ -4100,6 +4495,7 @@ libcrun_container_exec_with_options (libcrun_context_t *context, const char *id,
           .pid = pid,
           .context = context,
           .terminal_fd = terminal_fd,
+          .relay_buffer_size = get_relay_buffer_size (container),
           .notify_socket = -1,
           .container_ready_fd = NULL,
           .seccomp_notify_fd = seccomp_notify_fd,
@@ -4114,51 +4510,360 @@ libcrun_container_exec_with_options (libcrun_context_t *context, const char *id,
   return ret;
 }
 
-int
-libcrun_container_update (libcrun_context_t *context, const char *id, const char *content, size_t len arg_unused,
-                          libcrun_error_t *err)
+/* Spawn one process of a batch, JOIN_FDS and SECCOMP_FD are shared by all
+   of them.  Returns the pid of the new process.  */
+static pid_t
+exec_batch_spawn_process (libcrun_context_t *context, libcrun_container_t *container,
+                          libcrun_container_status_t *status, runtime_spec_schema_config_schema_process *process,
+                          struct libcrun_join_fds_s *join_fds, int seccomp_fd, int seccomp_receiver_fd,
+                          struct custom_handler_instance_s *custom_handler, libcrun_error_t *err)
 {
-  cleanup_custom_handler_instance struct custom_handler_instance_s *custom_handler = NULL;
-  runtime_spec_schema_config_linux_resources *resources = NULL;
-  cleanup_container libcrun_container_t *container = NULL;
-  const char *state_root = context->state_root;
-  struct parser_context ctx = { 0, stderr };
-  libcrun_container_status_t status = {};
-  parser_error parser_err = NULL;
-  yajl_val tree = NULL;
+  cleanup_close int pipefd0 = -1;
+  cleanup_close int pipefd1 = -1;
+  int container_ret_status[2];
+  int ret_from_child = 0;
+  pid_t pid;
   int ret;
 
-  ret = libcrun_read_container_status (&status, state_root, id, err);
+  /* A socketpair and not a pipe: the child blocks reading its pid from
+     pipefd1 until the rlimits are set, then reports its status back.  */
+  ret = socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, container_ret_status);
   if (UNLIKELY (ret < 0))
-    return ret;
+    return crun_make_error (err, errno, "socketpair");
+  pipefd0 = container_ret_status[0];
+  pipefd1 = container_ret_status[1];
 
-  ret = read_container_config_from_state (&container, state_root, id, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
+  set_exec_process_defaults (container, process);
 
-  ret = libcrun_configure_handler (context->handler_manager,
-                                   context,
-                                   container,
-                                   &custom_handler,
-                                   err);
+  ret = initialize_security (container, process, err);
   if (UNLIKELY (ret < 0))
     return ret;
 
-  ret = parse_json_file (&tree, content, &ctx, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
+  pid = libcrun_join_process (context, container, status->pid, status, NULL, context->detach, process, NULL, join_fds,
+                              err);
+  if (UNLIKELY (pid < 0))
+    return pid;
 
-  resources = make_runtime_spec_schema_config_linux_resources (tree, &ctx, &parser_err);
-  if (UNLIKELY (resources == NULL))
+  /* Process to exec.  */
+  if (pid == 0)
     {
-      ret = crun_make_error (err, errno, "cannot parse resources: %s", parser_err);
-      goto cleanup;
-    }
+      close_and_reset (&pipefd0);
 
-  if (custom_handler && custom_handler->vtable->modify_oci_configuration)
-    {
-      /* Adapt RESOURCES to be used from the modify_oci_configuration hook.  */
-      cleanup_free runtime_spec_schema_config_linux *linux = xmalloc0 (sizeof (*linux));
+      exec_process_entrypoint (context, container, process, &pipefd1, seccomp_fd, seccomp_receiver_fd, custom_handler,
+                               err);
+      /* It gets here only on errors.  */
+      if (*err)
+        {
+          if (pipefd1 < 0)
+            libcrun_fail_with_error ((*err)->status, "%s", (*err)->msg);
+          else
+            {
+              const char *msg = (*err)->msg;
+              ret = crun_error_get_errno (err);
+              TEMP_FAILURE_RETRY (write (pipefd1, &ret, sizeof (ret)));
+              TEMP_FAILURE_RETRY (write (pipefd1, msg, strlen (msg) + 1));
+            }
+        }
+      _exit (EXIT_FAILURE);
+    }
+
+  close_and_reset (&pipefd1);
+
+  /* Set the rlimits from here, as crun is still privileged in the user
+     namespace, and crun keeps its own limits for the next processes in
+     the batch.  The child does not go further until it receives its pid
+     below.  */
+  ret = libcrun_set_rlimits_for_pid (pid, process->rlimits, process->rlimits_len, err);
+  if (UNLIKELY (ret < 0))
+    {
+      kill (pid, SIGKILL);
+      if (! context->detach)
+        waitpid_ignore_stopped (pid, NULL, 0);
+      return ret;
+    }
+
+  ret = TEMP_FAILURE_RETRY (write (pipefd0, &pid, sizeof (pid)));
+  if (UNLIKELY (ret != sizeof (pid)))
+    {
+      ret = crun_make_error (err, errno, "write pid to the exec process");
+      kill (pid, SIGKILL);
+      if (! context->detach)
+        waitpid_ignore_stopped (pid, NULL, 0);
+      return ret;
+    }
+
+  ret = TEMP_FAILURE_RETRY (read (pipefd0, &ret_from_child, sizeof (ret_from_child)));
+  if (ret != sizeof (ret_from_child))
+    return crun_make_error (err, 0, "read pipe failed");
+  if (ret_from_child != 0)
+    {
+      cleanup_free char *msg = NULL;
+      size_t len = 0;
+
+      ret = read_all_fd (pipefd0, "error stream", &msg, &len, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+      /* the string from read_all_fd is always NUL terminated.  */
+      return crun_make_error (err, ret_from_child, "%s", msg);
+    }
+
+  return pid;
+}
+
+int
+libcrun_container_exec_batch (libcrun_context_t *context, const char *id,
+                              runtime_spec_schema_config_schema_process **processes, size_t n, int *exit_codes,
+                              libcrun_error_t *err)
+{
+  cleanup_custom_handler_instance struct custom_handler_instance_s *custom_handler = NULL;
+  cleanup_container_status libcrun_container_status_t status = {};
+  cleanup_container libcrun_container_t *container = NULL;
+  cleanup_close int own_seccomp_receiver_fd = -1;
+  cleanup_close int seccomp_receiver_fd = -1;
+  cleanup_close int seccomp_fd = -1;
+  struct libcrun_seccomp_gen_ctx_s seccomp_gen_ctx;
+  const char *seccomp_notify_plugins = NULL;
+  struct libcrun_join_fds_s join_fds;
+  cleanup_free pid_t *pids = NULL;
+  cleanup_free char *dir = NULL;
+  bool container_paused = false;
+  size_t i, spawned = 0;
+  int ret;
+
+  for (i = 0; i < n; i++)
+    if (processes[i]->terminal)
+      return crun_make_error (err, EINVAL, "a terminal cannot be used with batch exec");
+
+  ret = libcrun_read_container_status (&status, context->state_root, id, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = libcrun_is_container_running (&status, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+  if (ret == 0)
+    return crun_make_error (err, 0, "the container `%s` is not running", id);
+
+  ret = libcrun_get_state_directory (&dir, context->state_root, id, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  container = load_exec_config_file (dir, err);
+  if (UNLIKELY (container == NULL))
+    return -1;
+
+  container->context = context;
+
+  {
+    cleanup_cgroup_status struct libcrun_cgroup_status *cgroup_status = NULL;
+
+    cgroup_status = libcrun_cgroup_make_status (&status);
+
+    ret = libcrun_cgroup_is_container_paused (cgroup_status, &container_paused, err);
+    if (UNLIKELY (ret < 0))
+      return ret;
+  }
+
+  if (UNLIKELY (container_paused))
+    return crun_make_error (err, 0, "the container `%s` is paused", id);
+
+  ret = libcrun_configure_handler (context->handler_manager, context, container, &custom_handler, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = block_signals (err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  /* The seccomp filter is read once and each process loads it from the
+     same fd.  */
+  libcrun_seccomp_gen_ctx_init (&seccomp_gen_ctx, container, false, 0);
+
+  ret = libcrun_open_seccomp_bpf (&seccomp_gen_ctx, &seccomp_fd, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  if (seccomp_fd >= 0)
+    {
+      ret = get_seccomp_receiver_fd (container, &seccomp_receiver_fd, &own_seccomp_receiver_fd,
+                                     &seccomp_notify_plugins, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      if (own_seccomp_receiver_fd >= 0)
+        return crun_make_error (err, 0, "seccomp notify plugins cannot be used with batch exec");
+    }
+
+  ret = prctl (PR_SET_DUMPABLE, 0, 0, 0, 0);
+  if (UNLIKELY (ret < 0))
+    return crun_make_error (err, errno, "prctl unset dumpable");
+
+  ret = libcrun_join_fds_open (container, &status, NULL, &join_fds, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  pids = xmalloc0 (sizeof (pid_t) * (n + 1));
+  for (spawned = 0; spawned < n; spawned++)
+    {
+      pid_t pid;
+
+      pid = exec_batch_spawn_process (context, container, &status, processes[spawned], &join_fds, seccomp_fd,
+                                      seccomp_receiver_fd, custom_handler, err);
+      if (UNLIKELY (pid < 0))
+        {
+          ret = pid;
+          break;
+        }
+      pids[spawned] = pid;
+    }
+
+  libcrun_join_fds_close (&join_fds);
+
+  if (UNLIKELY (ret < 0))
+    {
+      /* Do not leave behind a partial batch.  */
+      for (i = 0; i < spawned; i++)
+        kill (pids[i], SIGKILL);
+      if (! context->detach)
+        for (i = 0; i < spawned; i++)
+          waitpid_ignore_stopped (pids[i], NULL, 0);
+      return ret;
+    }
+
+  if (context->detach)
+    return 0;
+
+  for (i = 0; i < n; i++)
+    {
+      int wait_status;
+
+      ret = waitpid_ignore_stopped (pids[i], &wait_status, 0);
+      if (UNLIKELY (ret < 0))
+        return crun_make_error (err, errno, "waitpid");
+
+      if (exit_codes)
+        exit_codes[i] = get_process_exit_status (wait_status);
+    }
+
+  return 0;
+}
+
+int
+libcrun_container_exec_batch_file (libcrun_context_t *context, const char *id, const char *path,
+                                   libcrun_error_t *err)
+{
+  struct parser_context ctx = { 0, stderr };
+  runtime_spec_schema_config_schema_process **processes = NULL;
+  cleanup_free char *content = NULL;
+  cleanup_free int *exit_codes = NULL;
+  yajl_val tree = NULL;
+  size_t i, n = 0;
+  size_t len;
+  int ret;
+
+  ret = read_all_file (path, &content, &len, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = parse_json_file (&tree, content, &ctx, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  if (! YAJL_IS_ARRAY (tree))
+    {
+      ret = crun_make_error (err, EINVAL, "the batch file `%s` must contain an array of processes", path);
+      goto exit;
+    }
+
+  n = YAJL_GET_ARRAY (tree)->len;
+  processes = xmalloc0 (sizeof (*processes) * (n + 1));
+  for (i = 0; i < n; i++)
+    {
+      parser_error parser_err = NULL;
+
+      processes[i] = make_runtime_spec_schema_config_schema_process (YAJL_GET_ARRAY (tree)->values[i], &ctx,
+                                                                     &parser_err);
+      if (UNLIKELY (processes[i] == NULL))
+        {
+          ret = crun_make_error (err, errno, "cannot parse process %zu in `%s`: `%s`", i, path, parser_err);
+          free (parser_err);
+          goto exit;
+        }
+      free (parser_err);
+    }
+
+  exit_codes = xmalloc0 (sizeof (int) * (n + 1));
+  ret = libcrun_container_exec_batch (context, id, processes, n, exit_codes, err);
+  if (UNLIKELY (ret < 0))
+    goto exit;
+
+  /* Like exec, return the exit code of the first process that failed.  */
+  for (i = 0; i < n; i++)
+    if (exit_codes[i] != 0)
+      {
+        ret = exit_codes[i];
+        break;
+      }
+
+exit:
+  if (processes)
+    {
+      for (i = 0; i < n; i++)
+        if (processes[i])
+          free_runtime_spec_schema_config_schema_process (processes[i]);
+      free (processes);
+    }
+  yajl_tree_free (tree);
+  return ret;
+}
+
+/* Read the state of the container ID and parse the resources in CONTENT.  */
+static int
+prepare_container_update (libcrun_context_t *context, const char *id, const char *content,
+                          libcrun_container_status_t *status,
+                          runtime_spec_schema_config_linux_resources **out,
+                          libcrun_error_t *err)
+{
+  cleanup_custom_handler_instance struct custom_handler_instance_s *custom_handler = NULL;
+  runtime_spec_schema_config_linux_resources *resources = NULL;
+  cleanup_container libcrun_container_t *container = NULL;
+  const char *state_root = context->state_root;
+  struct parser_context ctx = { 0, stderr };
+  parser_error parser_err = NULL;
+  yajl_val tree = NULL;
+  int ret;
+
+  ret = libcrun_read_container_status (status, state_root, id, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = read_container_config_from_state (&container, state_root, id, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = libcrun_configure_handler (context->handler_manager,
+                                   context,
+                                   container,
+                                   &custom_handler,
+                                   err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = parse_json_file (&tree, content, &ctx, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  resources = make_runtime_spec_schema_config_linux_resources (tree, &ctx, &parser_err);
+  if (UNLIKELY (resources == NULL))
+    {
+      ret = crun_make_error (err, errno, "cannot parse resources: %s", parser_err);
+      goto cleanup;
+    }
+
+  if (custom_handler && custom_handler->vtable->modify_oci_configuration)
+    {
+      /* Adapt RESOURCES to be used from the modify_oci_configuration hook.  */
+      cleanup_free runtime_spec_schema_config_linux *linux = xmalloc0 (sizeof (*linux));
       cleanup_free runtime_spec_schema_config_schema *def = xmalloc0 (sizeof (*def));
 
       def->linux = linux;
@@ -4169,10 +4874,12 @@ libcrun_container_update (libcrun_context_t *context, const char *id, const char
                                                               def,
                                                               err);
       if (UNLIKELY (ret < 0))
-        return ret;
+        goto cleanup;
     }
 
-  ret = libcrun_linux_container_update (&status, state_root, resources, err);
+  *out = resources;
+  resources = NULL;
+  ret = 0;
 
 cleanup:
   if (tree)
@@ -4184,6 +4891,58 @@ cleanup:
   return ret;
 }
 
+int
+libcrun_container_update (libcrun_context_t *context, const char *id, const char *content, size_t len arg_unused,
+                          libcrun_error_t *err)
+{
+  runtime_spec_schema_config_linux_resources *resources = NULL;
+  cleanup_container_status libcrun_container_status_t status = {};
+  int ret;
+
+  ret = prepare_container_update (context, id, content, &status, &resources, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = libcrun_linux_container_update (&status, context->state_root, resources, err);
+
+  free_runtime_spec_schema_config_linux_resources (resources);
+
+  return ret;
+}
+
+int
+libcrun_container_update_many (libcrun_context_t *context, const char **ids, const char **contents, size_t n,
+                               libcrun_error_t *err)
+{
+  runtime_spec_schema_config_linux_resources **resources;
+  libcrun_container_status_t *status;
+  size_t i;
+  int ret = 0;
+
+  status = xmalloc0 (sizeof (*status) * (n + 1));
+  resources = xmalloc0 (sizeof (*resources) * (n + 1));
+
+  for (i = 0; i < n; i++)
+    {
+      ret = prepare_container_update (context, ids[i], contents[i], &status[i], &resources[i], err);
+      if (UNLIKELY (ret < 0))
+        goto exit;
+    }
+
+  ret = libcrun_linux_container_update_many (status, context->state_root, resources, n, err);
+
+exit:
+  for (i = 0; i < n; i++)
+    {
+      if (resources[i])
+        free_runtime_spec_schema_config_linux_resources (resources[i]);
+      libcrun_free_container_status (&status[i]);
+    }
+  free (resources);
+  free (status);
+  return ret;
+}
+
 int
 libcrun_container_update_from_file (libcrun_context_t *context, const char *id, const char *file, libcrun_error_t *err)
 {
@@ -4211,16 +4970,12 @@ compare_update_values (const void *a, const void *b)
   return strcmp (aa->name, bb->name);
 }
 
-int
-libcrun_container_update_from_values (libcrun_context_t *context, const char *id,
-                                      struct libcrun_update_value_s *values, size_t len,
-                                      libcrun_error_t *err)
+static int
+generate_update_from_values (struct libcrun_update_value_s *values, size_t len, yajl_gen *out, libcrun_error_t *err)
 {
   const char *current_section = NULL;
-  const unsigned char *buf;
   yajl_gen gen = NULL;
-  size_t i, buf_len;
-  int ret;
+  size_t i;
 
   gen = yajl_gen_alloc (NULL);
   if (gen == NULL)
@@ -4253,6 +5008,24 @@ libcrun_container_update_from_values (libcrun_context_t *context, const char *id
 
   yajl_gen_map_close (gen);
 
+  *out = gen;
+  return 0;
+}
+
+int
+libcrun_container_update_from_values (libcrun_context_t *context, const char *id,
+                                      struct libcrun_update_value_s *values, size_t len,
+                                      libcrun_error_t *err)
+{
+  const unsigned char *buf;
+  yajl_gen gen = NULL;
+  size_t buf_len;
+  int ret;
+
+  ret = generate_update_from_values (values, len, &gen, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
   yajl_gen_get_buf (gen, &buf, &buf_len);
 
   ret = libcrun_container_update (context, id, (const char *) buf, buf_len, err);
@@ -4262,6 +5035,34 @@ libcrun_container_update_from_values (libcrun_context_t *context, const char *id
   return ret;
 }
 
+int
+libcrun_container_update_many_from_values (libcrun_context_t *context, const char **ids, size_t n,
+                                           struct libcrun_update_value_s *values, size_t len,
+                                           libcrun_error_t *err)
+{
+  cleanup_free const char **contents = NULL;
+  const unsigned char *buf;
+  yajl_gen gen = NULL;
+  size_t i, buf_len;
+  int ret;
+
+  ret = generate_update_from_values (values, len, &gen, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  yajl_gen_get_buf (gen, &buf, &buf_len);
+
+  contents = xmalloc0 (sizeof (*contents) * (n + 1));
+  for (i = 0; i < n; i++)
+    contents[i] = (const char *) buf;
+
+  ret = libcrun_container_update_many (context, ids, contents, n, err);
+
+  yajl_gen_free (gen);
+
+  return ret;
+}
+
 static void
 populate_array_field (char ***field, char *array[], size_t num_elements)
 {
@@ -4819,48 +5620,95 @@ libcrun_container_read_pids (libcrun_context_t *context, const char *id, bool re
   return libcrun_cgroup_read_pids (cgroup_status, recurse, pids, err);
 }
 
+static int
+flush_json_generator (yajl_gen gen, FILE *out, libcrun_error_t *err)
+{
+  const unsigned char *content = NULL;
+  size_t len;
+
+  if (yajl_gen_get_buf (gen, &content, &len) != yajl_gen_status_ok)
+    return crun_make_error (err, 0, "cannot generate json list");
+
+  if (len && fwrite (content, 1, len, out) != len)
+    return crun_make_error (err, errno, "error writing to file");
+
+  yajl_gen_clear (gen);
+  return 0;
+}
+
 int
 libcrun_write_json_containers_list (libcrun_context_t *context, FILE *out, libcrun_error_t *err)
 {
-  libcrun_container_list_t *list = NULL, *it;
-  const unsigned char *content = NULL;
+  cleanup_free char *run_directory = NULL;
+  cleanup_close int run_dirfd = -1;
+  cleanup_dir DIR *dir = NULL;
+  struct dirent *de;
   yajl_gen gen = NULL;
-  size_t len;
   int ret;
 
-  ret = libcrun_get_containers_list (&list, context->state_root, err);
+  ret = get_run_directory (&run_directory, context->state_root, err);
   if (UNLIKELY (ret < 0))
     return ret;
 
-  gen = yajl_gen_alloc (NULL);
-  if (gen == NULL)
+  /* Every lookup is done relative to the run directory, so that the path
+     is resolved only once and not for each file of each container.  */
+  run_dirfd = TEMP_FAILURE_RETRY (open (run_directory, O_DIRECTORY | O_RDONLY | O_CLOEXEC));
+  if (UNLIKELY (run_dirfd < 0))
+    return crun_make_error (err, errno, "open `%s`", run_directory);
+
+  ret = dup (run_dirfd);
+  if (UNLIKELY (ret < 0))
+    return crun_make_error (err, errno, "dup");
+
+  dir = fdopendir (ret);
+  if (UNLIKELY (dir == NULL))
     {
-      ret = crun_make_error (err, 0, "cannot allocate json generator");
-      goto exit;
+      close (ret);
+      return crun_make_error (err, errno, "cannot opendir `%s`", run_directory);
     }
 
+  gen = yajl_gen_alloc (NULL);
+  if (gen == NULL)
+    return crun_make_error (err, 0, "cannot allocate json generator");
+
   yajl_gen_config (gen, yajl_gen_beautify, 1);
   yajl_gen_config (gen, yajl_gen_validate_utf8, 1);
+
   yajl_gen_array_open (gen);
 
-  for (it = list; it; it = it->next)
+  for (de = readdir (dir); de; de = readdir (dir))
     {
-      libcrun_container_status_t status;
+      libcrun_container_status_t status = {};
+      const char *container_status = NULL;
       int running = 0;
       int pid;
-      const char *container_status = NULL;
 
-      ret = libcrun_read_container_status (&status, context->state_root, it->name, err);
+      if (de->d_name[0] == '.')
+        continue;
+
+      ret = libcrun_read_container_status_at (&status, run_dirfd, de->d_name, err);
       if (UNLIKELY (ret < 0))
-        goto exit;
+        {
+          /* Not a container directory.  */
+          if (crun_error_get_errno (err) == ENOENT)
+            {
+              crun_error_release (err);
+              continue;
+            }
 
-      pid = status.pid;
+          /* Part of the list may already be written, so do not stop
+             there and leave a truncated array.  */
+          libcrun_error_write_warning_and_release (stderr, &err);
+          libcrun_free_container_status (&status);
+          continue;
+        }
 
-      ret = libcrun_get_container_state_string (it->name, &status, context->state_root, &container_status,
-                                                &running, err);
+      pid = status.pid;
+      ret = get_container_state_string (de->d_name, &status, NULL, run_dirfd, &container_status, &running, err);
       if (UNLIKELY (ret < 0))
         {
           libcrun_error_write_warning_and_release (stderr, &err);
+          libcrun_free_container_status (&status);
           continue;
         }
 
@@ -4869,7 +5717,7 @@ libcrun_write_json_containers_list (libcrun_context_t *context, FILE *out, libcr
 
       yajl_gen_map_open (gen);
       yajl_gen_string (gen, YAJL_STR ("id"), strlen ("id"));
-      yajl_gen_string (gen, YAJL_STR (it->name), strlen (it->name));
+      yajl_gen_string (gen, YAJL_STR (de->d_name), strlen (de->d_name));
       yajl_gen_string (gen, YAJL_STR ("pid"), strlen ("pid"));
       yajl_gen_integer (gen, pid);
       yajl_gen_string (gen, YAJL_STR ("status"), strlen ("status"));
@@ -4883,35 +5731,186 @@ libcrun_write_json_containers_list (libcrun_context_t *context, FILE *out, libcr
       yajl_gen_map_close (gen);
 
       libcrun_free_container_status (&status);
+
+      /* Stream each entry instead of buffering the whole list.  */
+      ret = flush_json_generator (gen, out, err);
+      if (UNLIKELY (ret < 0))
+        goto exit;
     }
 
   yajl_gen_array_close (gen);
-  if (yajl_gen_get_buf (gen, &content, &len) != yajl_gen_status_ok)
+
+  ret = flush_json_generator (gen, out, err);
+
+exit:
+  if (gen)
+    yajl_gen_free (gen);
+  return ret;
+}
+
+static int
+write_event_line (yajl_gen gen, FILE *out, libcrun_error_t *err)
+{
+  int ret;
+
+  ret = flush_json_generator (gen, out, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  if (UNLIKELY (fputc ('\n', out) == EOF || fflush (out) == EOF))
+    return crun_make_error (err, errno, "error writing to file");
+
+  return 0;
+}
+
+static void
+generate_event_header (yajl_gen gen, const char *type, const char *id)
+{
+  yajl_gen_map_open (gen);
+  yajl_gen_string (gen, YAJL_STR ("type"), strlen ("type"));
+  yajl_gen_string (gen, YAJL_STR (type), strlen (type));
+  yajl_gen_string (gen, YAJL_STR ("id"), strlen ("id"));
+  yajl_gen_string (gen, YAJL_STR (id), strlen (id));
+}
+
+static int
+write_stats_event (struct libcrun_cgroup_stats *stats, yajl_gen gen, const char *id, bool delta, FILE *out,
+                   libcrun_error_t *err)
+{
+  int ret;
+
+  generate_event_header (gen, "stats", id);
+  yajl_gen_string (gen, YAJL_STR ("data"), strlen ("data"));
+  ret = libcrun_cgroup_stats_generate (stats, gen, delta, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+  yajl_gen_map_close (gen);
+
+  /* Nothing changed since the last sample, drop it.  */
+  if (ret == 0 && delta)
     {
-      ret = libcrun_make_error (err, 0, "cannot generate json list");
-      goto exit;
+      yajl_gen_clear (gen);
+      return 0;
     }
 
-  while (len)
+  return write_event_line (gen, out, err);
+}
+
+static int
+monotonic_ms (long long *out, libcrun_error_t *err)
+{
+  struct timespec ts;
+
+  if (UNLIKELY (clock_gettime (CLOCK_MONOTONIC, &ts) < 0))
+    return crun_make_error (err, errno, "clock_gettime");
+
+  *out = ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+  return 0;
+}
+
+int
+libcrun_container_events (libcrun_context_t *context, const char *id, bool stats_only, int interval, FILE *out,
+                          libcrun_error_t *err)
+{
+  cleanup_container_status libcrun_container_status_t status = {};
+  cleanup_cgroup_status struct libcrun_cgroup_status *cgroup_status = NULL;
+  cleanup_cgroup_stats struct libcrun_cgroup_stats *stats = NULL;
+  unsigned long long oom_kills;
+  bool delta = false;
+  yajl_gen gen = NULL;
+  int cgroup_mode;
+  int ret;
+
+  ret = libcrun_read_container_status (&status, context->state_root, id, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  if (status.cgroup_path == NULL || status.cgroup_path[0] == '\0')
+    return crun_make_error (err, 0, "the container is not using cgroups");
+
+  cgroup_mode = libcrun_get_cgroup_mode (err);
+  if (UNLIKELY (cgroup_mode < 0))
+    return cgroup_mode;
+
+  if (cgroup_mode != CGROUP_MODE_UNIFIED)
+    return crun_make_error (err, 0, "events are supported only on cgroup v2");
+
+  cgroup_status = libcrun_cgroup_make_status (&status);
+
+  ret = libcrun_cgroup_stats_open (cgroup_status, &stats, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  gen = yajl_gen_alloc (NULL);
+  if (gen == NULL)
+    return crun_make_error (err, errno, "yajl_gen_alloc");
+  yajl_gen_config (gen, yajl_gen_allow_multiple_values, 1);
+
+  oom_kills = libcrun_cgroup_stats_get_memory_event (stats, "oom_kill");
+
+  for (;;)
     {
-      size_t written = fwrite (content, 1, len, out);
-      if (ferror (out))
+      long long now, deadline;
+
+      /* The first sample is complete, the following ones carry only the
+         values that changed.  */
+      ret = write_stats_event (stats, gen, id, delta, out, err);
+      if (UNLIKELY (ret < 0))
+        goto exit;
+      delta = true;
+
+      if (stats_only)
+        break;
+
+      ret = monotonic_ms (&now, err);
+      if (UNLIKELY (ret < 0))
+        goto exit;
+      deadline = now + interval * 1000LL;
+
+      /* Sleep on the cgroup notifications until the next sample is due,
+         there is no need to poll the files in between.  */
+      while (now < deadline)
         {
-          ret = libcrun_make_error (err, errno, "error writing to file");
-          goto exit;
+          int mask;
+
+          mask = libcrun_cgroup_stats_wait (stats, deadline - now, err);
+          if (UNLIKELY (mask < 0))
+            {
+              ret = mask;
+              goto exit;
+            }
+
+          if (mask & LIBCRUN_CGROUP_STATS_MEMORY_EVENTS)
+            {
+              unsigned long long v = libcrun_cgroup_stats_get_memory_event (stats, "oom_kill");
+
+              if (v > oom_kills)
+                {
+                  generate_event_header (gen, "oom", id);
+                  yajl_gen_map_close (gen);
+                  ret = write_event_line (gen, out, err);
+                  if (UNLIKELY (ret < 0))
+                    goto exit;
+                }
+              oom_kills = v;
+            }
+
+          if (mask & LIBCRUN_CGROUP_STATS_EMPTY)
+            {
+              ret = 0;
+              goto exit;
+            }
+
+          ret = monotonic_ms (&now, err);
+          if (UNLIKELY (ret < 0))
+            goto exit;
         }
-      len -= written;
-      content += written;
     }
 
   ret = 0;
 
 exit:
-  if (list)
-    libcrun_free_containers_list (list);
-  if (gen)
-    yajl_gen_free (gen);
-
+  yajl_gen_free (gen);
   return ret;
 }
 
@@ -5003,6 +6002,33 @@ cleanup:
   return ret;
 }
 
+int
+libcrun_container_seccomp_compile (libcrun_context_t *context, libcrun_container_t *container, char **checksum,
+                                   libcrun_error_t *err)
+{
+  runtime_spec_schema_config_schema *def = container->container_def;
+  struct libcrun_seccomp_gen_ctx_s seccomp_gen_ctx;
+  int ret;
+
+  *checksum = NULL;
+
+  if (def->linux == NULL || def->linux->seccomp == NULL)
+    return 0;
+
+  /* The filter is copied as it is, nothing to compile.  */
+  if (find_run_oci_annotation (container, RUN_OCI_SECCOMP_BPF_DATA))
+    return 0;
+
+  libcrun_seccomp_gen_ctx_init (&seccomp_gen_ctx, container, true, get_seccomp_gen_options (container, NULL));
+
+  ret = libcrun_seccomp_compile (&seccomp_gen_ctx, context->state_root, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  *checksum = xstrdup (seccomp_gen_ctx.checksum);
+  return 0;
+}
+
 int
 libcrun_container_add_mounts_from_file (libcrun_context_t *context, const char *id, const char *file, libcrun_error_t *err)
 {
@@ -75,6 +75,8 @@ enum
   LIBCRUN_CREATE_OPTIONS_PREFORK = 1 << 0,
 };
 
+struct run_oci_annotations_s;
+
 struct libcrun_container_s
 {
   /* Container parsed from the runtime json file.  */
@@ -91,6 +93,9 @@ struct libcrun_container_s
 
   string_map *annotations;
 
+  /* The run.oci.* annotations, parsed when the container is loaded.  */
+  struct run_oci_annotations_s *run_oci_annotations;
+
   int proc_fd;
 
   void *private_data;
@@ -265,9 +270,26 @@ LIBCRUN_PUBLIC int libcrun_container_exec (libcrun_context_t *context, const cha
 LIBCRUN_PUBLIC int libcrun_container_exec_process_file (libcrun_context_t *context, const char *id, const char *path,
                                                         libcrun_error_t *err);
 
+/* Spawn N processes in the container, joining its namespaces and cgroup
+   with fds opened once for all of them.  Unless CONTEXT->detach is set,
+   wait for all the processes and store their exit codes in EXIT_CODES.  */
+LIBCRUN_PUBLIC int libcrun_container_exec_batch (libcrun_context_t *context, const char *id,
+                                                 runtime_spec_schema_config_schema_process **processes, size_t n,
+                                                 int *exit_codes, libcrun_error_t *err);
+
+/* Same as libcrun_container_exec_batch, reading the processes from a JSON
+   array in PATH.  Returns the exit code of the first process that failed.  */
+LIBCRUN_PUBLIC int libcrun_container_exec_batch_file (libcrun_context_t *context, const char *id, const char *path,
+                                                      libcrun_error_t *err);
+
 LIBCRUN_PUBLIC int libcrun_container_update (libcrun_context_t *context, const char *id, const char *content,
                                              size_t len, libcrun_error_t *err);
 
+/* Update N containers at once.  CONTENTS[i] is the resources JSON for
+   IDS[i].  With systemd, the changes are sent in a single batch.  */
+LIBCRUN_PUBLIC int libcrun_container_update_many (libcrun_context_t *context, const char **ids,
+                                                  const char **contents, size_t n, libcrun_error_t *err);
+
 LIBCRUN_PUBLIC int libcrun_container_update_from_file (libcrun_context_t *context, const char *id, const char *file,
                                                        libcrun_error_t *err);
 
@@ -283,6 +305,12 @@ LIBCRUN_PUBLIC int libcrun_container_update_from_values (libcrun_context_t *cont
                                                          struct libcrun_update_value_s *values, size_t len,
                                                          libcrun_error_t *err);
 
+/* Same as libcrun_container_update_many, with the same VALUES for all
+   the N containers in IDS.  */
+LIBCRUN_PUBLIC int libcrun_container_update_many_from_values (libcrun_context_t *context, const char **ids, size_t n,
+                                                              struct libcrun_update_value_s *values, size_t len,
+                                                              libcrun_error_t *err);
+
 struct libcrun_intel_rdt_update
 {
   const char *l3_cache_schema;
@@ -312,6 +340,16 @@ LIBCRUN_PUBLIC int libcrun_container_read_pids (libcrun_context_t *context, cons
 
 LIBCRUN_PUBLIC int libcrun_write_json_containers_list (libcrun_context_t *context, FILE *out, libcrun_error_t *err);
 
+LIBCRUN_PUBLIC int libcrun_container_events (libcrun_context_t *context, const char *id, bool stats_only,
+                                             int interval, FILE *out, libcrun_error_t *err);
+
+/* Compile the seccomp profile of CONTAINER and store it in the cache, so
+   that it is not generated again when a container using it is created.
+   On success, CHECKSUM is the cache key, or NULL if there is no profile to
+   compile.  */
+LIBCRUN_PUBLIC int libcrun_container_seccomp_compile (libcrun_context_t *context, libcrun_container_t *container,
+                                                      char **checksum, libcrun_error_t *err);
+
 LIBCRUN_PUBLIC int libcrun_container_add_mounts_from_file (libcrun_context_t *context, const char *id, const char *file,
                                                            libcrun_error_t *err);
 
@@ -21,6 +21,7 @@
 #include "custom-handler.h"
 #include "container.h"
 #include "utils.h"
+#include "annotations.h"
 #include "linux.h"
 #include <unistd.h>
 #include <sys/stat.h>
@@ -294,7 +295,7 @@ libcrun_configure_handler (struct custom_handler_manager_s *manager,
   if (annotation && (strcmp (annotation, "sandbox") == 0))
     return 0;
 
-  annotation = find_annotation (container, "run.oci.handler");
+  annotation = find_run_oci_annotation (container, RUN_OCI_HANDLER);
 
   /* Fail with EACCESS if global handler is already configured and there was an attempt to override it via spec.  */
   if (context->handler != NULL && annotation != NULL)
@@ -21,6 +21,7 @@
 #include <config.h>
 #include "../container.h"
 #include "../utils.h"
+#include "../annotations.h"
 #include "handler-utils.h"
 
 int
@@ -34,7 +35,7 @@ wasm_can_handle_container (libcrun_container_t *container, libcrun_error_t *err
 
   entrypoint_executable = container->container_def->process->args[0];
 
-  annotation = find_annotation (container, "run.oci.handler");
+  annotation = find_run_oci_annotation (container, RUN_OCI_HANDLER);
   if (annotation)
     {
 
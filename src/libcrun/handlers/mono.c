@@ -21,6 +21,7 @@
 #include "../custom-handler.h"
 #include "../container.h"
 #include "../utils.h"
+#include "../annotations.h"
 #include "../linux.h"
 #include <unistd.h>
 #include <sys/stat.h>
@@ -153,7 +154,7 @@ mono_can_handle_container (libcrun_container_t *container, libcrun_error_t *err
 {
   const char *annotation;
 
-  annotation = find_annotation (container, "run.oci.handler");
+  annotation = find_run_oci_annotation (container, RUN_OCI_HANDLER);
   if (annotation)
     return strcmp (annotation, "dotnet") == 0 ? 1 : 0;
 
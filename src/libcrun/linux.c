@@ -22,6 +22,7 @@
 #include "linux.h"
 #include "utils.h"
 #include "status.h"
+#include "annotations.h"
 #include <string.h>
 #include <sched.h>
 #include <fcntl.h>
@@ -122,6 +123,13 @@ struct remount_s
   char *data;
 };
 
+struct idmapped_userns_s
+{
+  /* The mappings used to create the user namespace.  */
+  char *mappings;
+  int userns_fd;
+};
+
 struct private_data_s
 {
   struct remount_s *remounts;
@@ -156,6 +164,16 @@ struct private_data_s
   char *maskdir_proc_path;
   bool maskdir_bind_failed;
   bool maskdir_warned;
+
+  /* Detached read-only mounts of the shared empty directory and of
+     /dev/null, cloned for every masked path.  */
+  int maskdir_template_fd;
+  int masknull_template_fd;
+  bool mask_template_failed;
+
+  /* User namespaces created for idmapped mounts.  */
+  struct idmapped_userns_s *idmapped_userns;
+  size_t idmapped_userns_len;
 };
 
 struct linux_namespace_s
@@ -169,11 +187,16 @@ static void
 cleanup_private_data (void *private_data)
 {
   struct private_data_s *p = private_data;
+  size_t i;
 
   if (p->rootfsfd >= 0)
     TEMP_FAILURE_RETRY (close (p->rootfsfd));
   if (p->maskdir_fd >= 0)
     TEMP_FAILURE_RETRY (close (p->maskdir_fd));
+  if (p->maskdir_template_fd >= 0)
+    TEMP_FAILURE_RETRY (close (p->maskdir_template_fd));
+  if (p->masknull_template_fd >= 0)
+    TEMP_FAILURE_RETRY (close (p->masknull_template_fd));
   if (p->mount_fds)
     cleanup_close_mapp (&(p->mount_fds));
   if (p->dev_fds)
@@ -184,6 +207,12 @@ cleanup_private_data (void *private_data)
   free (p->container_notify_socket_path);
   free (p->external_descriptors);
   free (p->maskdir_proc_path);
+  for (i = 0; i < p->idmapped_userns_len; i++)
+    {
+      TEMP_FAILURE_RETRY (close (p->idmapped_userns[i].userns_fd));
+      free (p->idmapped_userns[i].mappings);
+    }
+  free (p->idmapped_userns);
   free (p);
 }
 
@@ -197,6 +226,8 @@ get_private_data (struct libcrun_container_s *container)
       p->rootfsfd = -1;
       p->notify_socket_tree_fd = -1;
       p->maskdir_fd = -1;
+      p->maskdir_template_fd = -1;
+      p->masknull_template_fd = -1;
       container->cleanup_private_data = cleanup_private_data;
     }
   return container->private_data;
@@ -503,24 +534,113 @@ has_same_mappings (runtime_spec_schema_config_schema *def, runtime_spec_schema_d
   return true;
 }
 
-static pid_t
-maybe_create_userns_for_idmapped_mount (libcrun_container_t *container,
-                                        runtime_spec_schema_config_schema *def,
-                                        runtime_spec_schema_defs_mount *mnt,
-                                        const char *options, pid_t *pid_out,
-                                        libcrun_error_t *err)
+static int
+write_idmapped_mount_options (libcrun_container_t *container, runtime_spec_schema_config_schema *def, pid_t pid,
+                              const char *options, libcrun_error_t *err)
 {
-  cleanup_pid pid_t pid = -1;
+  cleanup_free char *dup_options = NULL;
+  char *option, *saveptr = NULL;
+
+  dup_options = xstrdup (options);
+
+  /* If there are no OCI mappings specified, then parse the annotation.  */
+  for (option = strtok_r (dup_options, ";", &saveptr); option; option = strtok_r (NULL, ";", &saveptr))
+    {
+      cleanup_free char *mappings = NULL;
+      cleanup_close int map_fd = -1;
+      bool is_uids = false;
+      size_t len = 0;
+      int ret;
+
+      if (has_prefix (option, "uids="))
+        {
+          is_uids = true;
+          map_fd = libcrun_open_proc_pid_file (container, pid, "uid_map", O_WRONLY, err);
+          if (UNLIKELY (map_fd < 0))
+            return map_fd;
+        }
+      else if (has_prefix (option, "gids="))
+        {
+          map_fd = libcrun_open_proc_pid_file (container, pid, "gid_map", O_WRONLY, err);
+          if (UNLIKELY (map_fd < 0))
+            return map_fd;
+        }
+      else
+        return crun_make_error (err, 0, "invalid option `%s` specified", option);
+
+      ret = parse_idmapped_mount_option (def, is_uids, option + 5 /* strlen ("uids="), strlen ("gids=")*/, &mappings, &len, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      ret = safe_write (map_fd, is_uids ? "uid_map" : "gid_map", mappings, len, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+    }
+
+  return 0;
+}
+
+/* Return a fd to the user namespace to use for the idmapped mount MNT.  If
+   MNT has the same mappings as the container, it is the user namespace of
+   PID.  Otherwise a user namespace is created with the mappings of MNT.
+   It is kept in the private data, keyed by the mappings, so that the
+   mounts with the same mappings share it.  */
+static int
+get_userns_for_idmapped_mount (libcrun_container_t *container,
+                               runtime_spec_schema_config_schema *def,
+                               runtime_spec_schema_defs_mount *mnt,
+                               const char *options, pid_t pid,
+                               libcrun_error_t *err)
+{
+  struct private_data_s *private_data = get_private_data (container);
   bool need_new_userns = mnt->uid_mappings_len ? ! has_same_mappings (def, mnt) : options != NULL;
+  cleanup_free char *uid_map = NULL;
+  cleanup_free char *gid_map = NULL;
+  cleanup_free char *key = NULL;
+  cleanup_pid pid_t created_pid = -1;
+  cleanup_close int fd = -1;
+  size_t uid_map_len = 0;
+  size_t gid_map_len = 0;
+  size_t i;
+  int ret;
 
   if (! need_new_userns)
-    return 0;
+    return libcrun_open_proc_pid_file (container, pid, "ns/user", O_RDONLY, err);
 
-  pid = syscall_clone (CLONE_NEWUSER | SIGCHLD, NULL);
-  if (UNLIKELY (pid < 0))
+  if (mnt->uid_mappings_len)
+    {
+      ret = format_mount_mappings (&uid_map, mnt->uid_mappings, mnt->uid_mappings_len, &uid_map_len, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      ret = format_mount_mappings (&gid_map, mnt->gid_mappings, mnt->gid_mappings_len, &gid_map_len, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      xasprintf (&key, "uids:%.*sgids:%.*s", (int) uid_map_len, uid_map, (int) gid_map_len, gid_map);
+    }
+  else
+    {
+      if (! options)
+        return crun_make_error (err, 0, "internal error: no mappings found");
+
+      xasprintf (&key, "options:%s", options);
+    }
+
+  for (i = 0; i < private_data->idmapped_userns_len; i++)
+    if (strcmp (private_data->idmapped_userns[i].mappings, key) == 0)
+      {
+        ret = fcntl (private_data->idmapped_userns[i].userns_fd, F_DUPFD_CLOEXEC, 0);
+        if (UNLIKELY (ret < 0))
+          return crun_make_error (err, errno, "dup user namespace fd");
+        return ret;
+      }
+
+  created_pid = syscall_clone (CLONE_NEWUSER | SIGCHLD, NULL);
+  if (UNLIKELY (created_pid < 0))
     return crun_make_error (err, errno, "clone");
 
-  if (pid == 0)
+  if (created_pid == 0)
     {
       prctl (PR_SET_PDEATHSIG, SIGKILL);
       while (1)
@@ -530,87 +650,51 @@ maybe_create_userns_for_idmapped_mount (libcrun_container_t *container,
 
   if (mnt->uid_mappings_len)
     {
-      cleanup_free char *uid_map = NULL;
-      cleanup_free char *gid_map = NULL;
-      size_t written = 0;
-      int ret;
-
-      ret = format_mount_mappings (&uid_map, mnt->uid_mappings, mnt->uid_mappings_len, &written, err);
-      if (UNLIKELY (ret < 0))
-        return ret;
-
-      cleanup_close int fd = -1;
-
-      fd = libcrun_open_proc_pid_file (container, pid, "uid_map", O_WRONLY, err);
+      fd = libcrun_open_proc_pid_file (container, created_pid, "uid_map", O_WRONLY, err);
       if (UNLIKELY (fd < 0))
         return fd;
 
-      ret = safe_write (fd, "uid_map", uid_map, written, err);
-      if (UNLIKELY (ret < 0))
-        return ret;
-
-      ret = format_mount_mappings (&gid_map, mnt->gid_mappings, mnt->gid_mappings_len, &written, err);
+      ret = safe_write (fd, "uid_map", uid_map, uid_map_len, err);
       if (UNLIKELY (ret < 0))
         return ret;
 
       close_and_reset (&fd);
 
-      fd = libcrun_open_proc_pid_file (container, pid, "gid_map", O_WRONLY, err);
+      fd = libcrun_open_proc_pid_file (container, created_pid, "gid_map", O_WRONLY, err);
       if (UNLIKELY (fd < 0))
         return fd;
 
-      ret = safe_write (fd, "gid_map", gid_map, written, err);
+      ret = safe_write (fd, "gid_map", gid_map, gid_map_len, err);
       if (UNLIKELY (ret < 0))
         return ret;
+
+      close_and_reset (&fd);
     }
   else
     {
-      cleanup_free char *dup_options = NULL;
-      char *option, *saveptr = NULL;
-
-      if (! options)
-        return crun_make_error (err, 0, "internal error: no mappings found");
-
-      dup_options = xstrdup (options);
-
-      /* If there are no OCI mappings specified, then parse the annotation.  */
-      for (option = strtok_r (dup_options, ";", &saveptr); option; option = strtok_r (NULL, ";", &saveptr))
-        {
-          cleanup_free char *mappings = NULL;
-          cleanup_close int map_fd = -1;
-          bool is_uids = false;
-          size_t len = 0;
-          int ret;
+      ret = write_idmapped_mount_options (container, def, created_pid, options, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+    }
 
-          if (has_prefix (option, "uids="))
-            {
-              is_uids = true;
-              map_fd = libcrun_open_proc_pid_file (container, pid, "uid_map", O_WRONLY, err);
-              if (UNLIKELY (map_fd < 0))
-                return map_fd;
-            }
-          else if (has_prefix (option, "gids="))
-            {
-              map_fd = libcrun_open_proc_pid_file (container, pid, "gid_map", O_WRONLY, err);
-              if (UNLIKELY (map_fd < 0))
-                return map_fd;
-            }
-          else
-            return crun_make_error (err, 0, "invalid option `%s` specified", option);
+  /* The fd keeps the user namespace alive, the process is not needed
+     anymore and it is killed on return.  */
+  fd = libcrun_open_proc_pid_file (container, created_pid, "ns/user", O_RDONLY, err);
+  if (UNLIKELY (fd < 0))
+    return fd;
 
-          ret = parse_idmapped_mount_option (def, is_uids, option + 5 /* strlen ("uids="), strlen ("gids=")*/, &mappings, &len, err);
-          if (UNLIKELY (ret < 0))
-            return ret;
+  ret = fcntl (fd, F_DUPFD_CLOEXEC, 0);
+  if (UNLIKELY (ret < 0))
+    return crun_make_error (err, errno, "dup user namespace fd");
 
-          ret = safe_write (map_fd, is_uids ? "uid_map" : "gid_map", mappings, len, err);
-          if (UNLIKELY (ret < 0))
-            return ret;
-        }
-    }
+  private_data->idmapped_userns = xrealloc (private_data->idmapped_userns,
+                                            (private_data->idmapped_userns_len + 1) * sizeof (*private_data->idmapped_userns));
+  private_data->idmapped_userns[private_data->idmapped_userns_len].mappings = key;
+  private_data->idmapped_userns[private_data->idmapped_userns_len].userns_fd = get_and_reset (&fd);
+  private_data->idmapped_userns_len++;
+  key = NULL;
 
-  *pid_out = pid;
-  pid = -1;
-  return 0;
+  return ret;
 }
 
 int
@@ -1012,6 +1096,90 @@ fallback_to_tmpfs:
   return ret = do_mount (container, "tmpfs", pathfd, rel_path, "tmpfs", MS_RDONLY, "nr_blocks=1,nr_inodes=1", LABEL_MOUNT, err);
 }
 
+/* Get or create the read-only template for the masked paths: a detached
+   mount of the shared empty directory if IS_DIR is set, of /dev/null
+   otherwise.  It is created once per container.  */
+static int
+get_mask_template (libcrun_container_t *container, bool is_dir, libcrun_error_t *err)
+{
+  struct private_data_s *private_data = get_private_data (container);
+  int *template_fd = is_dir ? &private_data->maskdir_template_fd : &private_data->masknull_template_fd;
+  struct mount_attr_s attr = {
+    0,
+  };
+  cleanup_close int fd = -1;
+  int ret;
+
+  if (*template_fd >= 0)
+    return *template_fd;
+
+  if (is_dir)
+    {
+      char *proc_fd_path = NULL;
+
+      ret = get_shared_empty_dir_cached (container, &proc_fd_path, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      fd = syscall_open_tree (private_data->maskdir_fd, "", AT_EMPTY_PATH | OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC);
+    }
+  else
+    fd = syscall_open_tree (AT_FDCWD, "/dev/null", OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC);
+  if (UNLIKELY (fd < 0))
+    return crun_make_error (err, errno, "open_tree `%s`", is_dir ? "empty directory" : "/dev/null");
+
+  attr.attr_set = MOUNT_ATTR_RDONLY;
+  ret = syscall_mount_setattr (fd, "", AT_EMPTY_PATH, &attr);
+  if (UNLIKELY (ret < 0))
+    return crun_make_error (err, errno, "mount_setattr read-only mask template");
+
+  *template_fd = get_and_reset (&fd);
+  return *template_fd;
+}
+
+/* Mask the path at PATHFD with a clone of the template.  The clone is
+   already read-only, so it needs no remount.  Returns 1 if the path was
+   masked, 0 if the caller must fall back to a bind mount.  */
+static int
+mount_mask_from_template (libcrun_container_t *container, int pathfd, const char *rel_path, bool is_dir)
+{
+  struct private_data_s *private_data = get_private_data (container);
+  libcrun_error_t tmp_err = NULL;
+  cleanup_close int clonefd = -1;
+  int template_fd;
+  int ret;
+
+  if (private_data->mask_template_failed)
+    return 0;
+
+  template_fd = get_mask_template (container, is_dir, &tmp_err);
+  if (UNLIKELY (template_fd < 0))
+    goto fail;
+
+  /* Cloning a detached mount is not supported by older kernels.  */
+  clonefd = syscall_open_tree (template_fd, "", AT_EMPTY_PATH | OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC);
+  if (UNLIKELY (clonefd < 0))
+    {
+      crun_make_error (&tmp_err, errno, "clone the mask template");
+      goto fail;
+    }
+
+  ret = fs_move_mount_to (clonefd, pathfd, NULL);
+  if (UNLIKELY (ret < 0))
+    {
+      crun_make_error (&tmp_err, errno, "move mount to `%s`", rel_path);
+      goto fail;
+    }
+
+  return 1;
+
+fail:
+  libcrun_debug ("cannot use the mask template for `%s`: %s", rel_path, tmp_err->msg);
+  crun_error_release (&tmp_err);
+  private_data->mask_template_failed = true;
+  return 0;
+}
+
 static int
 do_masked_or_readonly_path (libcrun_container_t *container, const char *rel_path, bool readonly, bool keep_flags,
                             libcrun_error_t *err)
@@ -1067,6 +1235,9 @@ do_masked_or_readonly_path (libcrun_container_t *container, const char *rel_path
       if (UNLIKELY (ret < 0))
         return crun_make_error (err, errno, "cannot stat `%s`", rel_path);
 
+      if (mount_mask_from_template (container, pathfd, rel_path, (mode & S_IFMT) == S_IFDIR))
+        return 0;
+
       if ((mode & S_IFMT) == S_IFDIR)
         ret = mount_masked_dir (container, pathfd, rel_path, err);
       else
@@ -1082,7 +1253,7 @@ get_selinux_context_type (libcrun_container_t *container)
 {
   const char *context_type;
 
-  context_type = find_annotation (container, "run.oci.mount_context_type");
+  context_type = find_run_oci_annotation (container, RUN_OCI_MOUNT_CONTEXT_TYPE);
   if (context_type)
     return context_type;
 
@@ -1994,7 +2165,7 @@ append_mode_if_missing (char *data, const char *mode)
 static const char *
 get_force_cgroup_v1_annotation (libcrun_container_t *container)
 {
-  return find_annotation (container, "run.oci.systemd.force_cgroup_v1");
+  return find_run_oci_annotation (container, RUN_OCI_SYSTEMD_FORCE_CGROUP_V1);
 }
 
 static int
@@ -3015,15 +3186,9 @@ can_setgroups (libcrun_container_t *container, libcrun_error_t *err)
   if (get_private_data (container)->deny_setgroups)
     return 0;
 
-  if (container->container_def->annotations)
-    {
-      const char *annotation;
-
-      /* Skip setgroups if the annotation is set to anything different than "0".  */
-      annotation = find_annotation (container, "run.oci.keep_original_groups");
-      if (annotation)
-        return strcmp (annotation, "0") == 0 ? 1 : 0;
-    }
+  /* Skip setgroups if the annotation is set to anything different than "0".  */
+  if (find_run_oci_annotation (container, RUN_OCI_KEEP_ORIGINAL_GROUPS))
+    return find_run_oci_annotation_bool (container, RUN_OCI_KEEP_ORIGINAL_GROUPS, false) ? 0 : 1;
 
   {
     cleanup_close int fd = -1;
@@ -3462,6 +3627,13 @@ get_rlimit_resource (const char *name)
 int
 libcrun_set_rlimits (runtime_spec_schema_config_schema_process_rlimits_element **new_rlimits, size_t len,
                      libcrun_error_t *err)
+{
+  return libcrun_set_rlimits_for_pid (0, new_rlimits, len, err);
+}
+
+int
+libcrun_set_rlimits_for_pid (pid_t pid, runtime_spec_schema_config_schema_process_rlimits_element **new_rlimits,
+                             size_t len, libcrun_error_t *err)
 {
   size_t i;
   for (i = 0; i < len; i++)
@@ -3476,7 +3648,7 @@ libcrun_set_rlimits (runtime_spec_schema_config_schema_process_rlimits_element *
       libcrun_debug ("Set rlimit: soft = `%llu`, hard = `%llu`",
                      (unsigned long long) limit.rlim_cur,
                      (unsigned long long) limit.rlim_max);
-      if (UNLIKELY (setrlimit (resource, &limit) < 0))
+      if (UNLIKELY (prlimit (pid, resource, &limit, NULL) < 0))
         return crun_make_error (err, errno, "setrlimit `%s`", type);
     }
   return 0;
@@ -4012,8 +4184,6 @@ join_namespaces (runtime_spec_schema_config_schema *def, int *namespaces_to_join
   return 0;
 }
 
-#define MAX_NAMESPACES 10
-
 struct init_status_s
 {
   /* fd to the namespace to join.  */
@@ -4267,11 +4437,97 @@ open_mount_of_type (runtime_spec_schema_defs_mount *mnt, int *out_fd, libcrun_er
   return 0;
 }
 
+/* Create the tmpfs for MNT from the host, as a detached mount with its
+   options already applied.  It is used only when the container runs in
+   the same user namespace, so that the owner of the file system is the
+   same as if it was created from the container.  *OUT_FD is set to -1 if
+   the mount must be created from the container.  The read-only flag is
+   left to the remount done from the container, after the mounts below
+   it are created.  */
+static int
+open_tmpfs_mount_from_host (runtime_spec_schema_config_schema *def, runtime_spec_schema_defs_mount *mnt, int *out_fd,
+                            libcrun_error_t *err)
+{
+  cleanup_close int fsopen_fd = -1;
+  cleanup_close int newfs_fd = -1;
+  cleanup_free char *data = NULL;
+  unsigned long extra_flags = 0;
+  unsigned int attr_flags = 0;
+  char *option, *saveptr = NULL;
+  unsigned long flags = 0;
+  uint64_t rec_clear = 0;
+  uint64_t rec_set = 0;
+  size_t i;
+  int ret;
+
+  *out_fd = -1;
+
+  if (mnt->type == NULL || strcmp (mnt->type, "tmpfs") != 0 || mnt->options == NULL)
+    return 0;
+
+  /* A tmpfs on the rootfs itself replaces it, which is handled only by do_mount.  */
+  if (is_empty_string (consume_slashes (mnt->destination)))
+    return 0;
+
+  /* The label is applied as a mount option, let the container handle it.  */
+  if (def->linux && def->linux->mount_label)
+    return 0;
+
+  for (i = 0; i < mnt->options_len; i++)
+    flags |= get_mount_flags_or_option (mnt->options[i], flags, &extra_flags, &data, &rec_clear, &rec_set);
+
+  /* Without an explicit mode, the mode of the target in the rootfs is used.  */
+  if (data == NULL || strstr (data, "mode=") == NULL)
+    return 0;
+
+  if (flags & (MS_BIND | MS_REMOUNT | MS_MOVE))
+    return 0;
+
+  fsopen_fd = syscall_fsopen ("tmpfs", FSOPEN_CLOEXEC);
+  if (UNLIKELY (fsopen_fd < 0))
+    return crun_make_error (err, errno, "fsopen `tmpfs`");
+
+  for (option = strtok_r (data, ",", &saveptr); option; option = strtok_r (NULL, ",", &saveptr))
+    {
+      char *value = strchr (option, '=');
+
+      if (value)
+        *value++ = '\0';
+
+      ret = syscall_fsconfig (fsopen_fd, value ? FSCONFIG_SET_STRING : FSCONFIG_SET_FLAG, option, value, 0);
+      if (UNLIKELY (ret < 0))
+        return crun_make_error (err, errno, "fsconfig `%s` for `%s`", option, mnt->destination);
+    }
+
+  ret = syscall_fsconfig (fsopen_fd, FSCONFIG_CMD_CREATE, NULL, NULL, 0);
+  if (UNLIKELY (ret < 0))
+    return crun_make_error (err, errno, "fsconfig create `tmpfs`");
+
+  if (flags & MS_NOSUID)
+    attr_flags |= MOUNT_ATTR_NOSUID;
+  if (flags & MS_NODEV)
+    attr_flags |= MOUNT_ATTR_NODEV;
+  if (flags & MS_NOEXEC)
+    attr_flags |= MOUNT_ATTR_NOEXEC;
+  if (flags & MS_NOATIME)
+    attr_flags |= MOUNT_ATTR_NOATIME;
+  else if (flags & MS_STRICTATIME)
+    attr_flags |= MOUNT_ATTR_STRICTATIME;
+  if (flags & MS_NODIRATIME)
+    attr_flags |= MOUNT_ATTR_NODIRATIME;
+
+  newfs_fd = syscall_fsmount (fsopen_fd, FSMOUNT_CLOEXEC, attr_flags);
+  if (UNLIKELY (newfs_fd < 0))
+    return crun_make_error (err, errno, "fsmount `tmpfs`");
+
+  *out_fd = get_and_reset (&newfs_fd);
+  return 0;
+}
+
 static int
 maybe_get_idmapped_mount (libcrun_container_t *container, runtime_spec_schema_config_schema *def, runtime_spec_schema_defs_mount *mnt, pid_t pid, int *out_fd, bool *has_mappings_out, libcrun_error_t *err)
 {
   cleanup_close int newfs_fd = -1;
-  cleanup_pid pid_t created_pid = -1;
   struct mount_attr_s attr = {
     0,
   };
@@ -4311,13 +4567,7 @@ maybe_get_idmapped_mount (libcrun_container_t *container, runtime_spec_schema_co
         }
     }
 
-  ret = maybe_create_userns_for_idmapped_mount (container, def, mnt, options, &created_pid, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
-  if (created_pid > 0)
-    pid = created_pid;
-
-  fd = libcrun_open_proc_pid_file (container, pid, "ns/user", O_RDONLY, err);
+  fd = get_userns_for_idmapped_mount (container, def, mnt, options, pid, err);
   if (UNLIKELY (fd < 0))
     return fd;
 
@@ -4477,6 +4727,18 @@ prepare_and_send_mount_mounts (libcrun_container_t *container, pid_t pid, int sy
             crun_error_release (err);
         }
 
+      /* In the same user namespace, a tmpfs is the same whether it is created here or from the
+         container, so prepare it now with its options.  On failure, it is created from the container.  */
+      if (mount_fd < 0 && ! has_mappings && ! has_userns)
+        {
+          ret = open_tmpfs_mount_from_host (def, def->mounts[i], &mount_fd, err);
+          if (UNLIKELY (ret < 0))
+            {
+              crun_error_release (err);
+              mount_fd = -1;
+            }
+        }
+
       if (mount_fd >= 0)
         how_many++;
 
@@ -4945,7 +5207,7 @@ handle_pidfd_receiver (pid_t pid, libcrun_container_t *container, libcrun_error_
   cleanup_close int pidfd = -1;
   const char *v;
 
-  v = find_annotation (container, "run.oci.pidfd_receiver");
+  v = find_run_oci_annotation (container, RUN_OCI_PIDFD_RECEIVER);
   if (v == NULL)
     return 0;
 
@@ -5370,22 +5632,24 @@ join_process_parent_helper (libcrun_context_t *context,
 }
 
 /*
-  try to join all the namespaces with a single call to setns using the target process pidfd.
+  open a pidfd for the target process, if it can be used to join all the
+  namespaces with a single call to setns.
 
   return codes:
   < 0 - on errors
-  0   - the namespaces were not joined.
-  > 0 - the namespaces were joined.
+  0   - *PIDFD is set, or -1 if the pidfd cannot be used.
 */
 static int
-try_setns_with_pidfd (pid_t pid_to_join, libcrun_container_t *container, libcrun_container_status_t *status, libcrun_error_t *err)
+open_pidfd_to_join (pid_t pid_to_join, libcrun_container_t *container, libcrun_container_status_t *status, int *pidfd,
+                    libcrun_error_t *err)
 {
   runtime_spec_schema_config_schema *def = container->container_def;
   cleanup_close int pidfd_pid_to_join = -1;
-  int all_flags = 0;
   size_t i;
   int ret;
 
+  *pidfd = -1;
+
   /* If there is any explicit namespace path to join, skip the setns_with_pidfd
      shortcut and join each namespace individually.  */
   if (def->linux && def->linux->namespaces)
@@ -5406,10 +5670,32 @@ try_setns_with_pidfd (pid_t pid_to_join, libcrun_container_t *container, libcrun
   if (ret == 0)
     return crun_make_error (err, ESRCH, "container process not found, the pid was reused");
 
+  *pidfd = pidfd_pid_to_join;
+  pidfd_pid_to_join = -1;
+  return 0;
+}
+
+/*
+  try to join all the namespaces with a single call to setns using the target process pidfd.
+
+  return codes:
+  0   - the namespaces were not joined.
+  > 0 - the namespaces were joined.
+*/
+static int
+try_setns_with_pidfd (int pidfd)
+{
+  int all_flags = 0;
+  size_t i;
+  int ret;
+
+  if (pidfd < 0)
+    return 0;
+
   for (i = 0; namespaces[i].ns_file; i++)
     all_flags |= namespaces[i].value;
 
-  ret = setns (pidfd_pid_to_join, all_flags);
+  ret = setns (pidfd, all_flags);
   if (UNLIKELY (ret < 0))
     return 0;
 
@@ -5417,30 +5703,9 @@ try_setns_with_pidfd (pid_t pid_to_join, libcrun_container_t *container, libcrun
 }
 
 static int
-join_process_namespaces (libcrun_container_t *container, pid_t pid_to_join, libcrun_container_status_t *status, libcrun_error_t *err)
+open_namespace_fds (libcrun_container_t *container, pid_t pid_to_join, int fds[MAX_NAMESPACES], libcrun_error_t *err)
 {
-  runtime_spec_schema_config_schema *def = container->container_def;
-  int fds_joined[MAX_NAMESPACES] = {
-    0,
-  };
-  int fds[MAX_NAMESPACES] = {
-    -1,
-  };
   size_t i;
-  int ret;
-
-  /* Try to join all namespaces in one shot with setns and pidfd.  */
-  ret = try_setns_with_pidfd (pid_to_join, container, status, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
-  /* Nothing left to do if the namespaces were joined.  */
-  if (LIKELY (ret > 0))
-    return 0;
-
-  /* If setns fails with the target pidfd, fall-back to join each namespace individually.  */
-
-  if (def->linux->namespaces_len >= MAX_NAMESPACES)
-    return crun_make_error (err, 0, "invalid configuration");
 
   for (i = 0; namespaces[i].ns_file; i++)
     {
@@ -5452,13 +5717,28 @@ join_process_namespaces (libcrun_container_t *container, pid_t pid_to_join, libc
         {
           /* If the namespace doesn't exist, just ignore it.  */
           if (errno == ENOENT)
-            continue;
+            {
+              crun_error_release (err);
+              continue;
+            }
 
-          ret = fds[i];
-          goto exit;
+          return fds[i];
         }
     }
 
+  return 0;
+}
+
+static int
+setns_namespace_fds (libcrun_container_t *container, int fds[MAX_NAMESPACES], libcrun_error_t *err)
+{
+  runtime_spec_schema_config_schema *def = container->container_def;
+  int fds_joined[MAX_NAMESPACES] = {
+    0,
+  };
+  size_t i;
+  int ret;
+
   for (i = 0; namespaces[i].ns_file; i++)
     {
       if (namespaces[i].value == CLONE_NEWUSER)
@@ -5501,21 +5781,124 @@ join_process_namespaces (libcrun_container_t *container, pid_t pid_to_join, libc
               continue;
             }
 
-          ret = crun_make_error (err, errno, "setns `%s`", namespaces[i].ns_file);
-          goto exit;
+          return crun_make_error (err, errno, "setns `%s`", namespaces[i].ns_file);
         }
       fds_joined[i] = 1;
     }
 
-  ret = 0;
+  return 0;
+}
+
+static int
+join_process_namespaces (libcrun_container_t *container, pid_t pid_to_join, libcrun_container_status_t *status,
+                         struct libcrun_join_fds_s *join_fds, libcrun_error_t *err)
+{
+  runtime_spec_schema_config_schema *def = container->container_def;
+  cleanup_close int pidfd = -1;
+  int fds[MAX_NAMESPACES];
+  size_t i;
+  int ret;
+
+  /* The fds were already opened by the caller.  */
+  if (join_fds)
+    {
+      if (try_setns_with_pidfd (join_fds->pidfd) > 0)
+        return 0;
+
+      return setns_namespace_fds (container, join_fds->ns_fds, err);
+    }
+
+  /* Try to join all namespaces in one shot with setns and pidfd.  */
+  ret = open_pidfd_to_join (pid_to_join, container, status, &pidfd, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+  /* Nothing left to do if the namespaces were joined.  */
+  if (LIKELY (try_setns_with_pidfd (pidfd) > 0))
+    return 0;
+
+  /* If setns fails with the target pidfd, fall-back to join each namespace individually.  */
+
+  if (def->linux->namespaces_len >= MAX_NAMESPACES)
+    return crun_make_error (err, 0, "invalid configuration");
+
+  for (i = 0; i < MAX_NAMESPACES; i++)
+    fds[i] = -1;
+
+  ret = open_namespace_fds (container, pid_to_join, fds, err);
+  if (LIKELY (ret == 0))
+    ret = setns_namespace_fds (container, fds, err);
 
-exit:
   for (i = 0; namespaces[i].ns_file; i++)
     close_and_reset (&fds[i]);
 
   return ret;
 }
 
+static int
+open_cgroup_dirfd_to_join (libcrun_container_t *container, libcrun_container_status_t *status, const char *sub_cgroup)
+{
+  cleanup_cgroup_status struct libcrun_cgroup_status *cgroup_status = NULL;
+  libcrun_error_t tmp_err = NULL;
+  int cgroup_dirfd;
+
+  /* The cgroup can be joined directly only when there are no additional
+     controllers not handled by cgroup v2.  */
+  if (get_force_cgroup_v1_annotation (container) != NULL)
+    return -1;
+
+  cgroup_status = libcrun_cgroup_make_status (status);
+
+  cgroup_dirfd = libcrun_get_cgroup_dirfd (cgroup_status, sub_cgroup, &tmp_err);
+  if (UNLIKELY (cgroup_dirfd < 0))
+    crun_error_release (&tmp_err);
+
+  return cgroup_dirfd;
+}
+
+int
+libcrun_join_fds_open (libcrun_container_t *container, libcrun_container_status_t *status, const char *sub_cgroup,
+                       struct libcrun_join_fds_s *join_fds, libcrun_error_t *err)
+{
+  runtime_spec_schema_config_schema *def = container->container_def;
+  size_t i;
+  int ret;
+
+  join_fds->pidfd = -1;
+  join_fds->cgroup_dirfd = -1;
+  for (i = 0; i < MAX_NAMESPACES; i++)
+    join_fds->ns_fds[i] = -1;
+
+  if (def->linux->namespaces_len >= MAX_NAMESPACES)
+    return crun_make_error (err, 0, "invalid configuration");
+
+  ret = open_pidfd_to_join (status->pid, container, status, &join_fds->pidfd, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  /* Open the namespaces also when the pidfd is available, as setns on a
+     pidfd is not supported by older kernels.  */
+  ret = open_namespace_fds (container, status->pid, join_fds->ns_fds, err);
+  if (UNLIKELY (ret < 0))
+    {
+      libcrun_join_fds_close (join_fds);
+      return ret;
+    }
+
+  join_fds->cgroup_dirfd = open_cgroup_dirfd_to_join (container, status, sub_cgroup);
+  return 0;
+}
+
+void
+libcrun_join_fds_close (struct libcrun_join_fds_s *join_fds)
+{
+  size_t i;
+
+  close_and_reset (&join_fds->pidfd);
+  close_and_reset (&join_fds->cgroup_dirfd);
+  for (i = 0; i < MAX_NAMESPACES; i++)
+    close_and_reset (&join_fds->ns_fds[i]);
+}
+
 int
 libcrun_join_process (libcrun_context_t *context,
                       libcrun_container_t *container,
@@ -5525,12 +5908,14 @@ libcrun_join_process (libcrun_context_t *context,
                       int detach,
                       runtime_spec_schema_config_schema_process *process,
                       int *terminal_fd,
+                      struct libcrun_join_fds_s *join_fds,
                       libcrun_error_t *err)
 {
   pid_t pid;
   int ret;
   int sync_socket_fd[2];
-  cleanup_close int cgroup_dirfd = -1;
+  cleanup_close int own_cgroup_dirfd = -1;
+  int cgroup_dirfd;
   cleanup_close int sync_fd = -1;
   struct _clone3_args clone3_args;
   bool need_move_to_cgroup;
@@ -5546,20 +5931,10 @@ libcrun_join_process (libcrun_context_t *context,
   if (UNLIKELY (ret < 0))
     return crun_make_error (err, errno, "error creating socketpair");
 
-  {
-    cleanup_cgroup_status struct libcrun_cgroup_status *cgroup_status = NULL;
-
-    cgroup_status = libcrun_cgroup_make_status (status);
-
-    /* The cgroup can be joined directly only when there are no additional
-       controllers not handled by cgroup v2.  */
-    if (get_force_cgroup_v1_annotation (container) == NULL)
-      {
-        cgroup_dirfd = libcrun_get_cgroup_dirfd (cgroup_status, sub_cgroup, err);
-        if (UNLIKELY (cgroup_dirfd < 0))
-          crun_error_release (err);
-      }
-  }
+  if (join_fds)
+    cgroup_dirfd = join_fds->cgroup_dirfd;
+  else
+    cgroup_dirfd = own_cgroup_dirfd = open_cgroup_dirfd_to_join (container, status, sub_cgroup);
 
   memset (&clone3_args, 0, sizeof (clone3_args));
   clone3_args.exit_signal = SIGCHLD;
@@ -5613,7 +5988,7 @@ libcrun_join_process (libcrun_context_t *context,
   close_and_reset (&sync_socket_fd[0]);
   sync_fd = sync_socket_fd[1];
 
-  ret = join_process_namespaces (container, pid_to_join, status, err);
+  ret = join_process_namespaces (container, pid_to_join, status, join_fds, err);
   if (UNLIKELY (ret < 0))
     {
       TEMP_FAILURE_RETRY (write (sync_fd, "1", 1));
@@ -5707,6 +6082,28 @@ libcrun_linux_container_update (libcrun_container_status_t *status, const char *
   return libcrun_update_cgroup_resources (cgroup_status, state_root, resources, err);
 }
 
+int
+libcrun_linux_container_update_many (libcrun_container_status_t *status, const char *state_root,
+                                     runtime_spec_schema_config_linux_resources **resources, size_t n,
+                                     libcrun_error_t *err)
+{
+  struct libcrun_cgroup_status **cgroup_status;
+  size_t i;
+  int ret;
+
+  cgroup_status = xmalloc0 (sizeof (*cgroup_status) * (n + 1));
+  for (i = 0; i < n; i++)
+    cgroup_status[i] = libcrun_cgroup_make_status (&status[i]);
+
+  ret = libcrun_update_cgroup_resources_many (cgroup_status, state_root, resources, n, err);
+
+  for (i = 0; i < n; i++)
+    libcrun_cgroup_status_free (cgroup_status[i]);
+  free (cgroup_status);
+
+  return ret;
+}
+
 static int
 libcrun_container_pause_unpause_linux (libcrun_container_status_t *status, const bool pause, libcrun_error_t *err)
 {
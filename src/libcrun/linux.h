@@ -73,6 +73,9 @@ int libcrun_set_caps (runtime_spec_schema_config_schema_process_capabilities *ca
                       int no_new_privileges, libcrun_error_t *err);
 int libcrun_set_rlimits (runtime_spec_schema_config_schema_process_rlimits_element **rlimits, size_t len,
                          libcrun_error_t *err);
+/* Like libcrun_set_rlimits, but for the process PID.  */
+int libcrun_set_rlimits_for_pid (pid_t pid, runtime_spec_schema_config_schema_process_rlimits_element **rlimits,
+                                 size_t len, libcrun_error_t *err);
 int libcrun_set_selinux_label (libcrun_container_t *container, runtime_spec_schema_config_schema_process *proc, bool now, libcrun_error_t *err);
 int libcrun_set_apparmor_profile (libcrun_container_t *container, runtime_spec_schema_config_schema_process *proc, bool now, libcrun_error_t *err);
 int libcrun_set_hostname (libcrun_container_t *container, libcrun_error_t *err);
@@ -80,13 +83,39 @@ int libcrun_set_domainname (libcrun_container_t *container, libcrun_error_t *err
 int libcrun_set_oom (libcrun_container_t *container, libcrun_error_t *err);
 int libcrun_set_sysctl (libcrun_container_t *container, libcrun_error_t *err);
 int libcrun_set_terminal (libcrun_container_t *container, libcrun_error_t *err);
+
+#define MAX_NAMESPACES 10
+
+/* The fds used to join a running container.  They are opened once and
+   reused when several processes join the same container.  */
+struct libcrun_join_fds_s
+{
+  /* pidfd of the container init process, or -1.  */
+  int pidfd;
+  /* fd for each namespace of the container init process, or -1.  */
+  int ns_fds[MAX_NAMESPACES];
+  /* The target cgroup, or -1 if it cannot be joined with clone3.  */
+  int cgroup_dirfd;
+};
+
+int libcrun_join_fds_open (libcrun_container_t *container, libcrun_container_status_t *status, const char *sub_cgroup,
+                           struct libcrun_join_fds_s *join_fds, libcrun_error_t *err);
+void libcrun_join_fds_close (struct libcrun_join_fds_s *join_fds);
+
+/* If JOIN_FDS is NULL, the fds are opened for this call only.  */
 int libcrun_join_process (libcrun_context_t *context, libcrun_container_t *container, pid_t pid_to_join,
                           libcrun_container_status_t *status, const char *cgroup, int detach,
-                          runtime_spec_schema_config_schema_process *process, int *terminal_fd, libcrun_error_t *err);
+                          runtime_spec_schema_config_schema_process *process, int *terminal_fd,
+                          struct libcrun_join_fds_s *join_fds, libcrun_error_t *err);
 int libcrun_linux_container_update (libcrun_container_status_t *status,
                                     const char *state_root,
                                     runtime_spec_schema_config_linux_resources *resources,
                                     libcrun_error_t *err);
+int libcrun_linux_container_update_many (libcrun_container_status_t *status,
+                                         const char *state_root,
+                                         runtime_spec_schema_config_linux_resources **resources,
+                                         size_t n,
+                                         libcrun_error_t *err);
 int libcrun_create_keyring (libcrun_container_t *container, const char *name, const char *label, libcrun_error_t *err);
 int libcrun_container_pause_linux (libcrun_container_status_t *status, libcrun_error_t *err);
 int libcrun_container_unpause_linux (libcrun_container_status_t *status, libcrun_error_t *err);
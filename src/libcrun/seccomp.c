@@ -37,6 +37,10 @@
 #include <sys/utsname.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <sys/file.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
 
 #if HAVE_STDATOMIC_H
 #  include <stdatomic.h>
@@ -83,19 +87,6 @@
 
 #define SECCOMP_CACHE_DIR ".cache/seccomp"
 
-/* On Linux 5.19.15 x86_64, tmpfs reports 20 bytes + 20 bytes for each entry, so allow
-   at least 32 entries.  */
-#define MIN_CACHE_DIR_INODE_SIZE (20 + 32 * 20)
-
-/* Heuristic to avoid the cache directory grows indefinitely.  The inode size for
-   the directory is proportional to the number of entries it contains and it is
-   cheaper to compute than iterating the cache directory.  */
-static inline off_t
-get_cache_dir_inode_max_size (off_t size_rundir)
-{
-  return size_rundir * 3 + MIN_CACHE_DIR_INODE_SIZE;
-}
-
 static int
 syscall_seccomp (unsigned int operation, unsigned int flags, void *args)
 {
@@ -368,7 +359,7 @@ seccomp_action_supports_errno (const char *action)
    < 0 in case of errors
    == 0 the checksum is supported and the value is in OUT.
  */
-static int
+int
 calculate_seccomp_checksum (runtime_spec_schema_config_linux_seccomp *seccomp, unsigned int seccomp_gen_options, seccomp_checksum_t out, libcrun_error_t *err)
 {
   blake3_hasher hasher;
@@ -474,104 +465,204 @@ open_rundir_dirfd (const char *state_root, libcrun_error_t *err)
   return dirfd;
 }
 
-struct cache_entry
+/* The cache is split in shards, one per first hex digit of the checksum:
+
+   .cache/seccomp/<c>/index
+   .cache/seccomp/<c>/<checksum>
+
+   Each shard holds at most SECCOMP_CACHE_SHARD_WAYS entries, and its index
+   file keeps the last time each of them was used.  Picking the entry to
+   evict needs only to read the index of a single shard, instead of
+   scanning the whole cache.  */
+#define SECCOMP_CACHE_SHARD_WAYS 8
+#define SECCOMP_CACHE_INDEX "index"
+
+struct seccomp_cache_record
 {
-  seccomp_checksum_t checksum;
-  struct timespec atime;
+  char checksum[sizeof (seccomp_checksum_t) - 1];
+  uint64_t last_used;
 };
 
+static uint64_t
+seccomp_cache_now ()
+{
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_REALTIME, &ts) < 0)
+    return 0;
+  return ((uint64_t) ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+static inline int
+get_cache_shard_path (char **out, const char *checksum, const char *name)
+{
+  return xasprintf (out, "%s/%c/%s", SECCOMP_CACHE_DIR, checksum[0], name);
+}
+
 static int
-compare_entries_by_atime (const void *a, const void *b)
+read_cache_index (int index_fd, struct seccomp_cache_record records[SECCOMP_CACHE_SHARD_WAYS], libcrun_error_t *err)
 {
-  const struct cache_entry *entry_a = a;
-  const struct cache_entry *entry_b = b;
-  int ret;
+  ssize_t r;
 
-  ret = entry_a->atime.tv_sec - entry_b->atime.tv_sec;
-  if (ret)
-    return ret;
+  memset (records, 0, sizeof (*records) * SECCOMP_CACHE_SHARD_WAYS);
 
-  return entry_a->atime.tv_nsec - entry_b->atime.tv_nsec;
+  /* A short read means the index is new or was truncated, the missing
+     records are left empty.  */
+  r = TEMP_FAILURE_RETRY (pread (index_fd, records, sizeof (*records) * SECCOMP_CACHE_SHARD_WAYS, 0));
+  if (UNLIKELY (r < 0))
+    return crun_make_error (err, errno, "read seccomp cache index");
+
+  return 0;
 }
 
 static int
-evict_cache (int root_dfd, libcrun_error_t *err)
+write_cache_record (int index_fd, size_t way, const struct seccomp_cache_record *record, libcrun_error_t *err)
+{
+  ssize_t r;
+
+  r = TEMP_FAILURE_RETRY (pwrite (index_fd, record, sizeof (*record), way * sizeof (*record)));
+  if (UNLIKELY (r < 0))
+    return crun_make_error (err, errno, "write seccomp cache index");
+  if (UNLIKELY ((size_t) r != sizeof (*record)))
+    return crun_make_error (err, 0, "short write to seccomp cache index");
+
+  return 0;
+}
+
+/* Record that CHECKSUM was just used.  This runs on every cache hit, so it
+   takes no lock: the timestamp is written with a single pwrite(2) and a
+   lost update only makes the eviction less precise.  */
+static void
+touch_cache_entry (int dirfd, const char *checksum)
 {
-  cleanup_close int cache_dir_fd = -1;
-  off_t cache_dir_inode_max_size;
-  struct stat st;
+  struct seccomp_cache_record records[SECCOMP_CACHE_SHARD_WAYS];
+  cleanup_free char *index_path = NULL;
+  cleanup_close int index_fd = -1;
+  libcrun_error_t tmp_err = NULL;
+  uint64_t now;
+  size_t i;
   int ret;
 
-  ret = TEMP_FAILURE_RETRY (fstat (root_dfd, &st));
-  if (UNLIKELY (ret < 0))
-    return crun_make_error (err, errno, "fstat rundir");
+  get_cache_shard_path (&index_path, checksum, SECCOMP_CACHE_INDEX);
 
-  cache_dir_inode_max_size = get_cache_dir_inode_max_size (st.st_size);
+  index_fd = TEMP_FAILURE_RETRY (openat (dirfd, index_path, O_RDWR | O_CLOEXEC));
+  if (UNLIKELY (index_fd < 0))
+    return;
 
-  cache_dir_fd = TEMP_FAILURE_RETRY (openat (root_dfd, SECCOMP_CACHE_DIR, O_DIRECTORY | O_CLOEXEC));
-  if (UNLIKELY (cache_dir_fd < 0))
+  ret = read_cache_index (index_fd, records, &tmp_err);
+  if (UNLIKELY (ret < 0))
     {
-      if (errno == ENOENT)
-        return 0;
-      return crun_make_error (err, errno, "open `%s`", SECCOMP_CACHE_DIR);
+      crun_error_release (&tmp_err);
+      return;
     }
 
-  ret = TEMP_FAILURE_RETRY (fstat (cache_dir_fd, &st));
-  if (ret == 0 && st.st_size > cache_dir_inode_max_size)
+  now = seccomp_cache_now ();
+  for (i = 0; i < SECCOMP_CACHE_SHARD_WAYS; i++)
     {
-      cleanup_free struct cache_entry *entries = NULL;
-      cleanup_dir DIR *d = NULL;
-      size_t i, n_entries = 0;
-      struct dirent *de;
-      int dfd;
-
-      d = fdopendir (cache_dir_fd);
-      if (d == NULL)
-        return crun_make_error (err, errno, "cannot open seccomp cache directory");
-      /* fdopendir owns the fd now.  */
-      cache_dir_fd = -1;
-
-      dfd = dirfd (d);
-      while ((de = readdir (d)))
-        {
-          if (de->d_name[0] == '.')
-            continue;
+      if (memcmp (records[i].checksum, checksum, sizeof (records[i].checksum)) != 0)
+        continue;
 
-          ret = TEMP_FAILURE_RETRY (fstatat (dfd, de->d_name, &st, AT_SYMLINK_NOFOLLOW));
-          if (UNLIKELY (ret < 0))
-            continue;
+      ret = TEMP_FAILURE_RETRY (pwrite (index_fd, &now, sizeof (now),
+                                        i * sizeof (records[i]) + offsetof (struct seccomp_cache_record, last_used)));
+      (void) ret;
+      return;
+    }
+}
 
-          /* The cache file is already used, it is pointless to free it.  */
-          if (st.st_nlink > 1)
-            continue;
+/* Add SRC_PATH, relative to DIRFD, to the cache as CHECKSUM.  If the shard
+   is full, the least recently used entry is replaced.  Entries with the
+   sticky bit set are never evicted.  */
+static int
+insert_cache_entry (int dirfd, const char *src_path, const char *checksum, libcrun_error_t *err)
+{
+  struct seccomp_cache_record records[SECCOMP_CACHE_SHARD_WAYS];
+  struct seccomp_cache_record *victim = NULL;
+  cleanup_free char *shard_path = NULL;
+  cleanup_free char *index_path = NULL;
+  cleanup_free char *dest_path = NULL;
+  cleanup_close int index_fd = -1;
+  bool found;
+  size_t i;
+  int ret;
 
-          /* If the sticky bit is set, then ignore it.  */
-          if (st.st_mode & S_ISVTX)
-            continue;
+  xasprintf (&shard_path, "%s/%c", SECCOMP_CACHE_DIR, checksum[0]);
+  get_cache_shard_path (&index_path, checksum, SECCOMP_CACHE_INDEX);
+  get_cache_shard_path (&dest_path, checksum, checksum);
 
-          if (strlen (de->d_name) != sizeof (seccomp_checksum_t) - 1)
-            {
-              /* No mercy for unknown files.  */
-              unlinkat (dfd, de->d_name, 0);
-              continue;
-            }
-          else
-            {
-              entries = xrealloc (entries, sizeof (struct cache_entry) * (n_entries + 1));
+  ret = crun_ensure_directory_at (dirfd, shard_path, 0700, true, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
 
-              memcpy (entries[n_entries].checksum, de->d_name, sizeof (seccomp_checksum_t));
-              entries[n_entries].atime = st.st_atim;
-              n_entries++;
-            }
-        }
+  index_fd = TEMP_FAILURE_RETRY (openat (dirfd, index_path, O_RDWR | O_CREAT | O_CLOEXEC, 0600));
+  if (UNLIKELY (index_fd < 0))
+    return crun_make_error (err, errno, "open `%s`", index_path);
+
+  /* Serialize the writers on the same shard.  The lock is released when
+     the fd is closed.  */
+  ret = TEMP_FAILURE_RETRY (flock (index_fd, LOCK_EX));
+  if (UNLIKELY (ret < 0))
+    return crun_make_error (err, errno, "flock `%s`", index_path);
+
+  ret = read_cache_index (index_fd, records, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  /* Prefer, in order: the same checksum, a free slot, the least recently
+     used entry.  */
+  for (i = 0; victim == NULL && i < SECCOMP_CACHE_SHARD_WAYS; i++)
+    if (memcmp (records[i].checksum, checksum, sizeof (records[i].checksum)) == 0)
+      victim = &records[i];
+
+  for (i = 0; victim == NULL && i < SECCOMP_CACHE_SHARD_WAYS; i++)
+    if (records[i].checksum[0] == '\0')
+      victim = &records[i];
 
-      qsort (entries, n_entries, sizeof (struct cache_entry), compare_entries_by_atime);
+  found = victim != NULL;
 
-      /* Attempt to delete half of them.  */
-      for (i = 0; i < (n_entries == 1 ? 1 : n_entries / 2); i++)
-        unlinkat (dfd, entries[i].checksum, 0);
+  for (i = 0; ! found && i < SECCOMP_CACHE_SHARD_WAYS; i++)
+    {
+      cleanup_free char *path = NULL;
+      struct stat st;
+
+      if (victim && records[i].last_used >= victim->last_used)
+        continue;
+
+      xasprintf (&path, "%s/%c/%.*s", SECCOMP_CACHE_DIR, checksum[0], (int) sizeof (records[i].checksum),
+                 records[i].checksum);
+
+      /* If the sticky bit is set, then ignore it.  */
+      ret = TEMP_FAILURE_RETRY (fstatat (dirfd, path, &st, AT_SYMLINK_NOFOLLOW));
+      if (ret == 0 && (st.st_mode & S_ISVTX))
+        continue;
+
+      victim = &records[i];
     }
-  return 0;
+
+  /* All the entries are pinned.  */
+  if (victim == NULL)
+    return 0;
+
+  if (victim->checksum[0] != '\0' && memcmp (victim->checksum, checksum, sizeof (victim->checksum)) != 0)
+    {
+      cleanup_free char *path = NULL;
+
+      xasprintf (&path, "%s/%c/%.*s", SECCOMP_CACHE_DIR, checksum[0], (int) sizeof (victim->checksum),
+                 victim->checksum);
+
+      /* Containers using the entry keep their own link to it.  */
+      ret = unlinkat (dirfd, path, 0);
+      if (UNLIKELY (ret < 0 && errno != ENOENT))
+        return crun_make_error (err, errno, "unlink `%s`", path);
+    }
+
+  ret = linkat (dirfd, src_path, dirfd, dest_path, 0);
+  if (UNLIKELY (ret < 0 && errno != EEXIST))
+    return crun_make_error (err, errno, "link `%s` to `%s`", src_path, dest_path);
+
+  memcpy (victim->checksum, checksum, sizeof (victim->checksum));
+  victim->last_used = seccomp_cache_now ();
+
+  return write_cache_record (index_fd, victim - records, victim, err);
 }
 
 static int
@@ -579,7 +670,6 @@ store_seccomp_cache (struct libcrun_seccomp_gen_ctx_s *ctx, libcrun_error_t *err
 {
   libcrun_container_t *container = ctx->container;
   cleanup_free char *src_path = NULL;
-  cleanup_free char *dest_path = NULL;
   cleanup_close int dirfd = -1;
   int ret;
 
@@ -598,22 +688,7 @@ store_seccomp_cache (struct libcrun_seccomp_gen_ctx_s *ctx, libcrun_error_t *err
   if (UNLIKELY (ret < 0))
     return ret;
 
-  ret = append_paths (&dest_path, err, SECCOMP_CACHE_DIR, ctx->checksum, NULL);
-  if (UNLIKELY (ret < 0))
-    return ret;
-
-  ret = crun_ensure_directory_at (dirfd, SECCOMP_CACHE_DIR, 0700, true, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
-
-  ret = evict_cache (dirfd, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
-
-  ret = linkat (dirfd, src_path, dirfd, dest_path, 0);
-  if (UNLIKELY (ret < 0 && errno != EEXIST))
-    return crun_make_error (err, errno, "link `%s` to `%s`", src_path, dest_path);
-  return 0;
+  return insert_cache_entry (dirfd, src_path, ctx->checksum, err);
 }
 
 static inline runtime_spec_schema_config_linux_seccomp *
@@ -645,15 +720,15 @@ find_in_cache (struct libcrun_seccomp_gen_ctx_s *ctx, int dirfd, const char *des
   if (UNLIKELY (ret < 0))
     return ret;
 
-  ret = append_paths (&cache_file_path, err, SECCOMP_CACHE_DIR, ctx->checksum, NULL);
-  if (UNLIKELY (ret < 0))
-    return ret;
+  get_cache_shard_path (&cache_file_path, ctx->checksum, ctx->checksum);
 
   ret = TEMP_FAILURE_RETRY (linkat (dirfd, cache_file_path, dirfd, dest_path, 0));
   if (UNLIKELY (ret < 0 && errno != ENOENT))
     return crun_make_error (err, errno, "linkat `%s` to `%s`", cache_file_path, dest_path);
 
   *created = ret == 0;
+  if (*created)
+    touch_cache_entry (dirfd, ctx->checksum);
 
   return 0;
 }
@@ -838,6 +913,70 @@ libcrun_generate_seccomp (struct libcrun_seccomp_gen_ctx_s *gen_ctx, libcrun_err
 #endif
 }
 
+int
+libcrun_seccomp_compile (struct libcrun_seccomp_gen_ctx_s *ctx, const char *state_root, libcrun_error_t *err)
+{
+  runtime_spec_schema_config_linux_seccomp *seccomp;
+  cleanup_free char *cache_file_path = NULL;
+  cleanup_free char *tmp_path = NULL;
+  cleanup_close int dirfd = -1;
+  cleanup_close int fd = -1;
+  unsigned int options;
+  int ret;
+
+  seccomp = get_seccomp_configuration (ctx);
+  if (seccomp == NULL)
+    return 0;
+
+  if (ctx->options & LIBCRUN_SECCOMP_SKIP_CACHE)
+    return crun_make_error (err, EINVAL, "the seccomp profile cannot be cached");
+
+  ret = calculate_seccomp_checksum (seccomp, ctx->options, ctx->checksum, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  dirfd = open_rundir_dirfd (state_root, err);
+  if (UNLIKELY (dirfd < 0))
+    return dirfd;
+
+  get_cache_shard_path (&cache_file_path, ctx->checksum, ctx->checksum);
+
+  /* Already compiled.  */
+  ret = faccessat (dirfd, cache_file_path, F_OK, AT_SYMLINK_NOFOLLOW);
+  if (ret == 0)
+    {
+      touch_cache_entry (dirfd, ctx->checksum);
+      return 0;
+    }
+
+  ret = crun_ensure_directory_at (dirfd, SECCOMP_CACHE_DIR, 0700, true, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  xasprintf (&tmp_path, "%s/.tmp-%d", SECCOMP_CACHE_DIR, getpid ());
+
+  fd = TEMP_FAILURE_RETRY (openat (dirfd, tmp_path, O_CLOEXEC | O_RDWR | O_CREAT | O_TRUNC, 0700));
+  if (UNLIKELY (fd < 0))
+    return crun_make_error (err, errno, "open `%s`", tmp_path);
+
+  /* The filter is stored below under the checksum computed above, there is
+     no container directory to link it from.  */
+  options = ctx->options;
+  ctx->options |= LIBCRUN_SECCOMP_SKIP_CACHE;
+  ctx->fd = fd;
+  ret = libcrun_generate_seccomp (ctx, err);
+  ctx->options = options;
+  ctx->fd = -1;
+  if (UNLIKELY (ret < 0))
+    goto exit;
+
+  ret = insert_cache_entry (dirfd, tmp_path, ctx->checksum, err);
+
+exit:
+  unlinkat (dirfd, tmp_path, 0);
+  return ret;
+}
+
 int
 libcrun_copy_seccomp (struct libcrun_seccomp_gen_ctx_s *gen_ctx, const char *b64_bpf, libcrun_error_t *err)
 {
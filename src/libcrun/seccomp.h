@@ -61,4 +61,13 @@ int libcrun_apply_seccomp (int infd, int listener_receiver_fd, const char *recei
                            size_t receiver_fd_payload_len, char **flags, size_t flags_len, libcrun_error_t *err);
 int libcrun_open_seccomp_bpf (struct libcrun_seccomp_gen_ctx_s *ctx, int *fd, libcrun_error_t *err);
 
+/* Compute the checksum of the SECCOMP profile, used as the cache key.  */
+int calculate_seccomp_checksum (runtime_spec_schema_config_linux_seccomp *seccomp, unsigned int seccomp_gen_options,
+                                seccomp_checksum_t out, libcrun_error_t *err);
+
+/* Generate the BPF filter for the container and store it in the cache
+   under STATE_ROOT, so that the next container using the same profile
+   finds it there.  */
+int libcrun_seccomp_compile (struct libcrun_seccomp_gen_ctx_s *ctx, const char *state_root, libcrun_error_t *err);
+
 #endif
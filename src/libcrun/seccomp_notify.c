@@ -23,6 +23,7 @@
 #  include <sys/ioctl.h>
 #  include <linux/seccomp.h>
 #  include <sys/sysmacros.h>
+#  include <poll.h>
 #endif
 
 #ifdef HAVE_DLOPEN
@@ -36,6 +37,10 @@
 #  define SECCOMP_USER_NOTIF_FLAG_CONTINUE (1UL << 0)
 #endif
 
+/* Maximum number of notifications handled for each wakeup, so that a
+   flood of notifications cannot starve the other fds in the loop.  */
+#define MAX_NOTIFICATIONS_PER_WAKEUP 64
+
 struct plugin
 {
   void *handle;
@@ -96,7 +101,7 @@ libcrun_load_seccomp_notify_plugins (struct seccomp_notify_context_s **out, cons
   ctx->sresp = xmalloc (ctx->sizes.seccomp_notif_resp);
 
   ctx->n_plugins = 1;
-  for (it = b; it; it = strchr (it, ':'))
+  for (it = strchr (plugins, ':'); it; it = strchr (it + 1, ':'))
     ctx->n_plugins++;
 
   ctx->plugins = xmalloc0 (sizeof (struct plugin) * (ctx->n_plugins + 1));
@@ -157,10 +162,10 @@ libcrun_load_seccomp_notify_plugins (struct seccomp_notify_context_s **out, cons
 #endif
 }
 
-LIBCRUN_PUBLIC int
-libcrun_seccomp_notify_plugins (struct seccomp_notify_context_s *ctx, int seccomp_fd, libcrun_error_t *err)
-{
 #if HAVE_DLOPEN && HAVE_SECCOMP_GET_NOTIF_SIZES && HAVE_SECCOMP
+static int
+handle_notification (struct seccomp_notify_context_s *ctx, int seccomp_fd, libcrun_error_t *err)
+{
   size_t i;
   int ret;
 
@@ -223,6 +228,40 @@ send_resp:
       return crun_make_error (err, errno, "ioctl");
     }
   return 0;
+}
+
+/* SECCOMP_IOCTL_NOTIF_RECV blocks even if the fd is non-blocking, so check
+   that another notification is pending before receiving it.  */
+static bool
+has_pending_notification (int seccomp_fd)
+{
+  struct pollfd pfd = {
+    .fd = seccomp_fd,
+    .events = POLLIN,
+  };
+
+  return TEMP_FAILURE_RETRY (poll (&pfd, 1, 0)) > 0 && (pfd.revents & POLLIN);
+}
+#endif
+
+LIBCRUN_PUBLIC int
+libcrun_seccomp_notify_plugins (struct seccomp_notify_context_s *ctx, int seccomp_fd, libcrun_error_t *err)
+{
+#if HAVE_DLOPEN && HAVE_SECCOMP_GET_NOTIF_SIZES && HAVE_SECCOMP
+  int i, ret;
+
+  /* Handle all the notifications that are already queued, instead of going
+     back to the event loop for each of them.  */
+  for (i = 0; i < MAX_NOTIFICATIONS_PER_WAKEUP; i++)
+    {
+      if (i > 0 && ! has_pending_notification (seccomp_fd))
+        break;
+
+      ret = handle_notification (ctx, seccomp_fd, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+    }
+  return 0;
 #else
   (void) ctx;
   (void) seccomp_fd;
@@ -47,7 +47,8 @@ typedef int (*run_oci_seccomp_notify_start_cb) (void **opaque, struct libcrun_lo
    0: not handled, try next plugin or return ENOTSUP if it is the last plugin.
    RUN_OCI_SECCOMP_NOTIFY_HANDLE_SEND_RESPONSE: sresp filled and ready to be notified to seccomp.
    RUN_OCI_SECCOMP_NOTIFY_HANDLE_DELAYED_RESPONSE: the notification will be handled internally by the plugin and
-   forwarded to seccomp_fd. It is useful for asynchronous handling.
+   forwarded to seccomp_fd. It is useful for asynchronous handling: the response can be sent from another thread
+   and in any order, so a slow request does not delay the notifications that follow it.
 */
 typedef int (*run_oci_seccomp_notify_handle_request_cb) (void *opaque, struct seccomp_notif_sizes *sizes,
                                                          struct seccomp_notif *sreq, struct seccomp_notif_resp *sresp,
@@ -29,6 +29,7 @@
 #include <sys/types.h>
 #include <dirent.h>
 #include <signal.h>
+#include <stdint.h>
 
 #define YAJL_STR(x) ((const unsigned char *) (x))
 
@@ -45,6 +46,43 @@ struct pid_stat
   unsigned long long starttime;
 };
 
+/* Compact on-disk representation of libcrun_container_status_t, stored in
+   the "status.bin" file.  It is a fixed size header followed by the
+   NUL-terminated strings, so it is read back with a single read and
+   without any parsing.  */
+#define STATUS_BINARY_MAGIC "CRST"
+#define STATUS_BINARY_VERSION 1
+#define STATUS_BINARY_NULL UINT32_MAX
+
+enum
+{
+  STATUS_STRING_BUNDLE = 0,
+  STATUS_STRING_ROOTFS,
+  STATUS_STRING_CGROUP_PATH,
+  STATUS_STRING_SCOPE,
+  STATUS_STRING_CREATED,
+  STATUS_STRING_EXTERNAL_DESCRIPTORS,
+  STATUS_STRING_OWNER,
+  STATUS_STRING_LAST,
+};
+
+struct status_binary_header
+{
+  char magic[4];
+  uint32_t version;
+  uint32_t size;
+  int32_t pid;
+  uint64_t process_start_time;
+  uint8_t systemd_cgroup;
+  uint8_t detached;
+  uint8_t padding[6];
+  /* Offset of each string from the beginning of the record, or
+     STATUS_BINARY_NULL.  */
+  uint32_t strings[STATUS_STRING_LAST];
+};
+
+static int status_format = LIBCRUN_STATUS_FORMAT_JSON;
+
 /* If ID is not NULL, then ennsure that it does not contain any slash.  */
 static int
 validate_id (const char *id, libcrun_error_t *err)
@@ -131,8 +169,21 @@ libcrun_get_state_directory (char **out, const char *state_root, const char *id,
   return 0;
 }
 
+int
+libcrun_set_status_format (const char *format, libcrun_error_t *err)
+{
+  if (strcmp (format, "json") == 0)
+    status_format = LIBCRUN_STATUS_FORMAT_JSON;
+  else if (strcmp (format, "binary") == 0)
+    status_format = LIBCRUN_STATUS_FORMAT_BINARY;
+  else
+    return crun_make_error (err, 0, "unknown status format `%s`", format);
+
+  return 0;
+}
+
 static int
-get_state_directory_status_file (char **out, const char *state_root, const char *id, libcrun_error_t *err)
+get_state_directory_status_file (char **out, const char *state_root, const char *id, bool binary, libcrun_error_t *err)
 {
   cleanup_free char *root = NULL;
   cleanup_free char *path = NULL;
@@ -146,7 +197,7 @@ get_state_directory_status_file (char **out, const char *state_root, const char
   if (UNLIKELY (ret < 0))
     return ret;
 
-  ret = append_paths (&path, err, root, id, "status", NULL);
+  ret = append_paths (&path, err, root, id, binary ? "status.bin" : "status", NULL);
   if (UNLIKELY (ret < 0))
     return ret;
 
@@ -220,6 +271,131 @@ read_pid_stat (pid_t pid, struct pid_stat *st, libcrun_error_t *err)
   return 0;
 }
 
+static void
+status_binary_add_string (char **buffer, size_t *len, struct status_binary_header *header, int index, const char *value)
+{
+  size_t value_len;
+
+  if (value == NULL)
+    {
+      header->strings[index] = STATUS_BINARY_NULL;
+      return;
+    }
+
+  value_len = strlen (value) + 1;
+  *buffer = xrealloc (*buffer, *len + value_len);
+  memcpy (*buffer + *len, value, value_len);
+  header->strings[index] = *len;
+  *len += value_len;
+}
+
+static int
+write_container_status_binary (const char *file, libcrun_container_status_t *status, libcrun_error_t *err)
+{
+  cleanup_free char *file_tmp = NULL;
+  cleanup_free char *buffer = NULL;
+  cleanup_close int fd_write = -1;
+  struct status_binary_header header;
+  size_t len = sizeof (header);
+  int ret;
+
+  memset (&header, 0, sizeof (header));
+  memcpy (header.magic, STATUS_BINARY_MAGIC, sizeof (header.magic));
+  header.version = STATUS_BINARY_VERSION;
+  header.pid = status->pid;
+  header.process_start_time = status->process_start_time;
+  header.systemd_cgroup = status->systemd_cgroup ? 1 : 0;
+  header.detached = status->detached ? 1 : 0;
+
+  buffer = xmalloc (len);
+  status_binary_add_string (&buffer, &len, &header, STATUS_STRING_BUNDLE, status->bundle);
+  status_binary_add_string (&buffer, &len, &header, STATUS_STRING_ROOTFS, status->rootfs);
+  status_binary_add_string (&buffer, &len, &header, STATUS_STRING_CGROUP_PATH, status->cgroup_path ? status->cgroup_path : "");
+  status_binary_add_string (&buffer, &len, &header, STATUS_STRING_SCOPE, status->scope ? status->scope : "");
+  status_binary_add_string (&buffer, &len, &header, STATUS_STRING_CREATED, status->created);
+  status_binary_add_string (&buffer, &len, &header, STATUS_STRING_EXTERNAL_DESCRIPTORS, status->external_descriptors);
+  status_binary_add_string (&buffer, &len, &header, STATUS_STRING_OWNER, status->owner);
+
+  if (UNLIKELY (len > UINT32_MAX))
+    return crun_make_error (err, EOVERFLOW, "status record too big");
+
+  header.size = len;
+  memcpy (buffer, &header, sizeof (header));
+
+  xasprintf (&file_tmp, "%s.tmp", file);
+  fd_write = open (file_tmp, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0700);
+  if (UNLIKELY (fd_write < 0))
+    return crun_make_error (err, errno, "cannot open status file");
+
+  ret = safe_write (fd_write, "status file", buffer, len, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  close_and_reset (&fd_write);
+
+  if (UNLIKELY (rename (file_tmp, file) < 0))
+    return crun_make_error (err, errno, "cannot rename status file");
+
+  return 0;
+}
+
+static int
+read_container_status_binary (libcrun_container_status_t *status, const char *file, const char *buffer, size_t len,
+                              libcrun_error_t *err)
+{
+  struct status_binary_header header;
+  char *values[STATUS_STRING_LAST];
+  size_t i;
+
+  if (UNLIKELY (len < sizeof (header)))
+    return crun_make_error (err, 0, "status file `%s` is truncated", file);
+
+  memcpy (&header, buffer, sizeof (header));
+
+  if (UNLIKELY (memcmp (header.magic, STATUS_BINARY_MAGIC, sizeof (header.magic)) != 0))
+    return crun_make_error (err, 0, "invalid status file `%s`", file);
+
+  if (UNLIKELY (header.version != STATUS_BINARY_VERSION))
+    return crun_make_error (err, 0, "unsupported version `%u` for the status file `%s`", header.version, file);
+
+  if (UNLIKELY (header.size != len))
+    return crun_make_error (err, 0, "status file `%s` is truncated", file);
+
+  for (i = 0; i < STATUS_STRING_LAST; i++)
+    {
+      uint32_t off = header.strings[i];
+
+      if (off == STATUS_BINARY_NULL)
+        {
+          values[i] = NULL;
+          continue;
+        }
+
+      if (UNLIKELY (off < sizeof (header) || off >= len || memchr (buffer + off, '\0', len - off) == NULL))
+        return crun_make_error (err, 0, "invalid status file `%s`", file);
+
+      values[i] = (char *) buffer + off;
+    }
+
+  if (UNLIKELY (values[STATUS_STRING_BUNDLE] == NULL || values[STATUS_STRING_ROOTFS] == NULL
+                || values[STATUS_STRING_CGROUP_PATH] == NULL || values[STATUS_STRING_CREATED] == NULL))
+    return crun_make_error (err, 0, "invalid status file `%s`", file);
+
+  status->pid = header.pid;
+  status->process_start_time = header.process_start_time;
+  status->systemd_cgroup = header.systemd_cgroup;
+  status->detached = header.detached;
+  status->bundle = xstrdup (values[STATUS_STRING_BUNDLE]);
+  status->rootfs = xstrdup (values[STATUS_STRING_ROOTFS]);
+  status->cgroup_path = xstrdup (values[STATUS_STRING_CGROUP_PATH]);
+  status->scope = values[STATUS_STRING_SCOPE] ? xstrdup (values[STATUS_STRING_SCOPE]) : NULL;
+  status->created = xstrdup (values[STATUS_STRING_CREATED]);
+  status->external_descriptors = values[STATUS_STRING_EXTERNAL_DESCRIPTORS] ? xstrdup (values[STATUS_STRING_EXTERNAL_DESCRIPTORS]) : NULL;
+  status->owner = values[STATUS_STRING_OWNER] ? xstrdup (values[STATUS_STRING_OWNER]) : NULL;
+
+  return 0;
+}
+
 int
 libcrun_write_container_status (const char *state_root, const char *id, libcrun_container_status_t *status,
                                 libcrun_error_t *err)
@@ -230,11 +406,12 @@ libcrun_write_container_status (const char *state_root, const char *id, libcrun_
   size_t len;
   cleanup_close int fd_write = -1;
   const unsigned char *buf = NULL;
+  bool binary = status_format == LIBCRUN_STATUS_FORMAT_BINARY;
   struct pid_stat st;
   const char *tmp;
   yajl_gen gen = NULL;
 
-  ret = get_state_directory_status_file (&file, state_root, id, err);
+  ret = get_state_directory_status_file (&file, state_root, id, binary, err);
   if (UNLIKELY (ret < 0))
     return ret;
 
@@ -244,6 +421,9 @@ libcrun_write_container_status (const char *state_root, const char *id, libcrun_
 
   status->process_start_time = st.starttime;
 
+  if (binary)
+    return write_container_status_binary (file, status, err);
+
   xasprintf (&file_tmp, "%s.tmp", file);
   fd_write = open (file_tmp, O_CREAT | O_WRONLY | O_CLOEXEC, 0700);
   if (UNLIKELY (fd_write < 0))
@@ -386,25 +566,51 @@ yajl_error:
   return yajl_error_to_crun_error (r, err);
 }
 
-int
-libcrun_read_container_status (libcrun_container_status_t *status, const char *state_root, const char *id,
-                               libcrun_error_t *err)
+/* If DIRFD is not AT_FDCWD, the status file is looked up relative to it
+   and STATE_ROOT is ignored.  */
+static int
+read_container_status_at (libcrun_container_status_t *status, int dirfd, const char *state_root, const char *id,
+                          libcrun_error_t *err)
 {
   cleanup_free char *buffer = NULL;
   char err_buffer[256];
+  bool binary = status_format == LIBCRUN_STATUS_FORMAT_BINARY;
+  int attempt;
   int ret;
   cleanup_free char *file = NULL;
   yajl_val tree, tmp;
+  size_t len;
 
-  ret = get_state_directory_status_file (&file, state_root, id, err);
-  if (UNLIKELY (ret < 0))
-    return ret;
+  /* Look first for the file in the configured format, then for the other
+     one, so that containers created with a different setting are found.  */
+  for (attempt = 0; attempt < 2; attempt++, binary = ! binary)
+    {
+      if (file)
+        {
+          free (file);
+          file = NULL;
+          crun_error_release (err);
+        }
+
+      if (dirfd == AT_FDCWD)
+        ret = get_state_directory_status_file (&file, state_root, id, binary, err);
+      else
+        ret = append_paths (&file, err, id, binary ? "status.bin" : "status", NULL);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      ret = read_all_file_at (dirfd, file, &buffer, &len, err);
+      if (ret >= 0 || crun_error_get_errno (err) != ENOENT)
+        break;
+    }
+
+  if (ret >= 0 && binary)
+    return read_container_status_binary (status, file, buffer, len, err);
 
-  ret = read_all_file (file, &buffer, NULL, err);
   if (UNLIKELY (ret < 0))
     {
 
-      if (crun_error_get_errno (err) == ENOENT)
+      if (dirfd == AT_FDCWD && crun_error_get_errno (err) == ENOENT)
         {
           cleanup_free char *statedir = NULL;
           libcrun_error_t tmp_err;
@@ -499,6 +705,26 @@ libcrun_read_container_status (libcrun_container_status_t *status, const char *s
   return 0;
 }
 
+int
+libcrun_read_container_status (libcrun_container_status_t *status, const char *state_root, const char *id,
+                               libcrun_error_t *err)
+{
+  return read_container_status_at (status, AT_FDCWD, state_root, id, err);
+}
+
+int
+libcrun_read_container_status_at (libcrun_container_status_t *status, int run_dirfd, const char *id,
+                                  libcrun_error_t *err)
+{
+  int ret;
+
+  ret = validate_id (id, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  return read_container_status_at (status, run_dirfd, NULL, id, err);
+}
+
 int
 libcrun_status_check_directories (const char *state_root, const char *id, libcrun_error_t *err)
 {
@@ -672,6 +898,20 @@ libcrun_get_containers_list (libcrun_container_list_t **out, const char *state_r
           return exists;
         }
 
+      if (! exists)
+        {
+          free (status_file);
+          status_file = NULL;
+
+          ret = append_paths (&status_file, err, root, next->d_name, "status.bin", NULL);
+          if (UNLIKELY (ret < 0))
+            return ret;
+
+          exists = crun_path_exists (status_file, err);
+          if (exists < 0)
+            return exists;
+        }
+
       if (! exists)
         {
           libcrun_error (errno, "error opening file `%s`", status_file);
@@ -804,6 +1044,24 @@ libcrun_status_write_exec_fifo (const char *state_root, const char *id, libcrun_
   return strtoll (buffer, NULL, 10);
 }
 
+int
+libcrun_status_has_read_exec_fifo_at (int run_dirfd, const char *id, libcrun_error_t *err)
+{
+  cleanup_free char *fifo_path = NULL;
+  int ret;
+
+  ret = append_paths (&fifo_path, err, id, "exec.fifo", NULL);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = faccessat (run_dirfd, fifo_path, F_OK, 0);
+  if (ret == 0)
+    return 1;
+  if (errno == ENOENT)
+    return 0;
+  return crun_make_error (err, errno, "access `%s`", fifo_path);
+}
+
 int
 libcrun_status_has_read_exec_fifo (const char *state_root, const char *id, libcrun_error_t *err)
 {
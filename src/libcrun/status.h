@@ -47,6 +47,14 @@ struct libcrun_container_status_s
 };
 typedef struct libcrun_container_status_s libcrun_container_status_t;
 
+enum
+{
+  LIBCRUN_STATUS_FORMAT_JSON = 0,
+  LIBCRUN_STATUS_FORMAT_BINARY,
+};
+
+LIBCRUN_PUBLIC int libcrun_set_status_format (const char *format, libcrun_error_t *err);
+
 LIBCRUN_PUBLIC void libcrun_free_container_status (libcrun_container_status_t *status);
 LIBCRUN_PUBLIC int libcrun_write_container_status (const char *state_root, const char *id,
                                                    libcrun_container_status_t *status, libcrun_error_t *err);
@@ -63,6 +71,9 @@ int libcrun_status_check_directories (const char *state_root, const char *id, li
 int libcrun_status_create_exec_fifo (const char *state_root, const char *id, libcrun_error_t *err);
 int libcrun_status_write_exec_fifo (const char *state_root, const char *id, libcrun_error_t *err);
 int libcrun_status_has_read_exec_fifo (const char *state_root, const char *id, libcrun_error_t *err);
+int libcrun_status_has_read_exec_fifo_at (int run_dirfd, const char *id, libcrun_error_t *err);
+int libcrun_read_container_status_at (libcrun_container_status_t *status, int run_dirfd, const char *id,
+                                      libcrun_error_t *err);
 int libcrun_check_pid_valid (libcrun_container_status_t *status, libcrun_error_t *err);
 int get_run_directory (char **out, const char *state_root, libcrun_error_t *err);
 int get_shared_empty_directory_path (char **out, const char *state_root, libcrun_error_t *err);
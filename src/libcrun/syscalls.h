@@ -45,6 +45,10 @@
 #  define FSCONFIG_CMD_CREATE 6
 #endif
 
+#ifndef FSCONFIG_SET_FLAG
+#  define FSCONFIG_SET_FLAG 0
+#endif
+
 #ifndef FSCONFIG_SET_STRING
 #  define FSCONFIG_SET_STRING 1
 #endif
@@ -54,6 +58,30 @@
 #  define MOUNT_ATTR_RDONLY 0x00000001 /* Mount read-only */
 #endif
 
+#ifndef MOUNT_ATTR_NOSUID
+#  define MOUNT_ATTR_NOSUID 0x00000002 /* Ignore suid and sgid bits */
+#endif
+
+#ifndef MOUNT_ATTR_NODEV
+#  define MOUNT_ATTR_NODEV 0x00000004 /* Disallow access to device special files */
+#endif
+
+#ifndef MOUNT_ATTR_NOEXEC
+#  define MOUNT_ATTR_NOEXEC 0x00000008 /* Disallow program execution */
+#endif
+
+#ifndef MOUNT_ATTR_NOATIME
+#  define MOUNT_ATTR_NOATIME 0x00000010 /* Do not update access times */
+#endif
+
+#ifndef MOUNT_ATTR_STRICTATIME
+#  define MOUNT_ATTR_STRICTATIME 0x00000020 /* Always perform atime updates */
+#endif
+
+#ifndef MOUNT_ATTR_NODIRATIME
+#  define MOUNT_ATTR_NODIRATIME 0x00000080 /* Do not update directory access times */
+#endif
+
 #ifndef MOUNT_ATTR_IDMAP
 #  define MOUNT_ATTR_IDMAP 0x00100000 /* Idmap mount to @userns_fd in struct mount_attr. */
 #endif
@@ -0,0 +1,305 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#define _GNU_SOURCE
+
+#include <config.h>
+#include "trace.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <yajl/yajl_gen.h>
+
+#define YAJL_STR(x) ((const unsigned char *) (x))
+
+struct trace_event
+{
+  char *name;
+  char phase;
+  int source;
+  unsigned long long ts;
+};
+
+static char *trace_file;
+static bool trace_file_exclusive;
+static struct trace_event *events;
+static size_t n_events;
+static size_t allocated_events;
+
+static void
+set_file (const char *file, bool exclusive)
+{
+  free (trace_file);
+  trace_file = file ? xstrdup (file) : NULL;
+  trace_file_exclusive = exclusive;
+  libcrun_trace_reset ();
+}
+
+void
+libcrun_trace_set_file (const char *file)
+{
+  set_file (file, false);
+}
+
+void
+libcrun_trace_set_container_file (const char *file)
+{
+  set_file (file, true);
+}
+
+bool
+libcrun_trace_enabled (void)
+{
+  return trace_file != NULL;
+}
+
+void
+libcrun_trace_add_event (const char *name, char phase, unsigned long long ts, int source)
+{
+  struct trace_event *ev;
+
+  if (trace_file == NULL)
+    return;
+
+  if (n_events == allocated_events)
+    {
+      allocated_events = allocated_events ? allocated_events * 2 : 32;
+      events = xrealloc (events, allocated_events * sizeof (*events));
+    }
+
+  ev = &events[n_events++];
+  ev->name = xstrdup (name);
+  ev->phase = phase;
+  ev->source = source;
+  ev->ts = ts;
+}
+
+static void
+trace_now (const char *name, char phase)
+{
+  struct timespec now;
+
+  if (trace_file == NULL)
+    return;
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  libcrun_trace_add_event (name, phase, now.tv_sec * 1000000ULL + now.tv_nsec / 1000, LIBCRUN_TRACE_RUNTIME);
+}
+
+void
+libcrun_trace_begin (const char *name)
+{
+  trace_now (name, 'B');
+}
+
+void
+libcrun_trace_end (const char *name)
+{
+  trace_now (name, 'E');
+}
+
+void
+libcrun_trace_reset (void)
+{
+  size_t i;
+
+  for (i = 0; i < n_events; i++)
+    free (events[i].name);
+  n_events = 0;
+}
+
+int
+libcrun_trace_foreach (int (*cb) (const char *name, char phase, unsigned long long ts, void *arg), void *arg)
+{
+  size_t i;
+  int ret;
+
+  for (i = 0; i < n_events; i++)
+    {
+      ret = cb (events[i].name, events[i].phase, events[i].ts, arg);
+      if (UNLIKELY (ret < 0))
+        return ret;
+    }
+  return 0;
+}
+
+static yajl_gen_status
+gen_key_string (yajl_gen gen, const char *key, const char *value)
+{
+  yajl_gen_status r;
+
+  r = yajl_gen_string (gen, YAJL_STR (key), strlen (key));
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  return yajl_gen_string (gen, YAJL_STR (value), strlen (value));
+}
+
+static yajl_gen_status
+gen_key_integer (yajl_gen gen, const char *key, long long value)
+{
+  yajl_gen_status r;
+
+  r = yajl_gen_string (gen, YAJL_STR (key), strlen (key));
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  return yajl_gen_integer (gen, value);
+}
+
+static yajl_gen_status
+gen_thread_name (yajl_gen gen, pid_t pid, int tid, const char *name)
+{
+  yajl_gen_status r;
+
+  r = yajl_gen_map_open (gen);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_string (gen, "name", "thread_name");
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_string (gen, "ph", "M");
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_integer (gen, "pid", pid);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_integer (gen, "tid", tid);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = yajl_gen_string (gen, YAJL_STR ("args"), strlen ("args"));
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = yajl_gen_map_open (gen);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_string (gen, "name", name);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = yajl_gen_map_close (gen);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  return yajl_gen_map_close (gen);
+}
+
+static yajl_gen_status
+gen_event (yajl_gen gen, pid_t pid, struct trace_event *ev)
+{
+  char phase[2] = { ev->phase, '\0' };
+  yajl_gen_status r;
+
+  r = yajl_gen_map_open (gen);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_string (gen, "name", ev->name);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_string (gen, "ph", phase);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_integer (gen, "ts", (long long) ev->ts);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_integer (gen, "pid", pid);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  r = gen_key_integer (gen, "tid", ev->source + 1);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    return r;
+
+  return yajl_gen_map_close (gen);
+}
+
+/* The file uses the JSON array format of the Chrome trace events, it can be
+   loaded in chrome://tracing or Perfetto.  The runtime and the container
+   init are shown as two threads of the same process.  The events are
+   dropped once they are written.  */
+int
+libcrun_trace_write (libcrun_error_t *err)
+{
+  const unsigned char *buf = NULL;
+  pid_t pid = getpid ();
+  size_t i, len = 0;
+  yajl_gen_status r;
+  yajl_gen gen;
+  int ret;
+
+  if (trace_file == NULL)
+    return 0;
+
+  gen = yajl_gen_alloc (NULL);
+  if (gen == NULL)
+    return crun_make_error (err, 0, "yajl_gen_alloc failed");
+
+  r = yajl_gen_array_open (gen);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    goto yajl_error;
+
+  r = gen_thread_name (gen, pid, LIBCRUN_TRACE_RUNTIME + 1, "crun");
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    goto yajl_error;
+
+  r = gen_thread_name (gen, pid, LIBCRUN_TRACE_INIT + 1, "container init");
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    goto yajl_error;
+
+  for (i = 0; i < n_events; i++)
+    {
+      r = gen_event (gen, pid, &events[i]);
+      if (UNLIKELY (r != yajl_gen_status_ok))
+        goto yajl_error;
+    }
+
+  r = yajl_gen_array_close (gen);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    goto yajl_error;
+
+  r = yajl_gen_get_buf (gen, &buf, &len);
+  if (UNLIKELY (r != yajl_gen_status_ok))
+    goto yajl_error;
+
+  /* A file requested by the container configuration is in the state
+     directory, never replace or follow anything that is already there.  */
+  if (trace_file_exclusive)
+    ret = write_file_at_with_flags (AT_FDCWD, O_CREAT | O_EXCL | O_NOFOLLOW, 0600, trace_file, buf, len, err);
+  else
+    ret = write_file (trace_file, buf, len, err);
+  yajl_gen_free (gen);
+  libcrun_trace_reset ();
+  return ret;
+
+yajl_error:
+  yajl_gen_free (gen);
+  libcrun_trace_reset ();
+  return yajl_error_to_crun_error (r, err);
+}
@@ -0,0 +1,68 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <config.h>
+#include <stdbool.h>
+#include "error.h"
+
+enum
+{
+  LIBCRUN_TRACE_RUNTIME = 0,
+  LIBCRUN_TRACE_INIT,
+};
+
+/* Record the phases of the container creation and write them to FILE, in
+   the Chrome trace event format.  */
+LIBCRUN_PUBLIC void libcrun_trace_set_file (const char *file);
+
+/* Same as libcrun_trace_set_file, for a trace requested by the container
+   configuration.  FILE must not exist, it is created with mode 0600 and
+   without following symlinks.  */
+void libcrun_trace_set_container_file (const char *file);
+
+static inline void
+cleanup_trace_filep (bool *set)
+{
+  if (*set)
+    libcrun_trace_set_file (NULL);
+}
+#define cleanup_trace_file __attribute__ ((cleanup (cleanup_trace_filep)))
+
+bool libcrun_trace_enabled (void);
+
+/* Mark the beginning and the end of the phase NAME.  NAME is copied.  */
+void libcrun_trace_begin (const char *name);
+void libcrun_trace_end (const char *name);
+
+/* Add an event recorded by another process.  PHASE is 'B' or 'E', TS is in
+   microseconds from CLOCK_MONOTONIC.  */
+void libcrun_trace_add_event (const char *name, char phase, unsigned long long ts, int source);
+
+/* Drop all the recorded events.  It is used by the container init, so that
+   it sends back only its own events.  */
+void libcrun_trace_reset (void);
+
+/* Call CB for each recorded event.  */
+int libcrun_trace_foreach (int (*cb) (const char *name, char phase, unsigned long long ts, void *arg), void *arg);
+
+/* Write the recorded events to the trace file, if any, and drop them.  */
+int libcrun_trace_write (libcrun_error_t *err);
+
+#endif
@@ -42,6 +42,7 @@
 #include <linux/magic.h>
 #include <limits.h>
 #include <sys/mman.h>
+#include <sys/sendfile.h>
 #ifdef HAVE_LINUX_OPENAT2_H
 #  include <linux/openat2.h>
 #endif
@@ -979,10 +980,12 @@ read_all_fd_with_size_hint (int fd, const char *description, char **out, size_t
           if (size)
             break;
 
+          /* Grow the buffer geometrically, so that reading a large file
+             whose size is not known does not copy it over and over.  */
           if (pagesize == 0)
             pagesize = get_page_size ();
 
-          allocated += pagesize;
+          allocated += allocated > pagesize ? allocated : pagesize;
 
           buf = xrealloc (buf, allocated + 1);
         }
@@ -1244,27 +1247,8 @@ create_signalfd (sigset_t *mask, libcrun_error_t *err)
   return ret;
 }
 
-static int
-epoll_helper_toggle (int epollfd, int fd, int events, libcrun_error_t *err)
-{
-  struct epoll_event ev = {};
-  bool add = events != 0;
-  int ret;
-
-  ev.events = events;
-  ev.data.fd = fd;
-  ret = epoll_ctl (epollfd, add ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd, &ev);
-  if (UNLIKELY (ret < 0))
-    {
-      if (errno == EEXIST || errno == ENOENT)
-        return 0;
-      return crun_make_error (err, errno, "epoll_ctl `%s` `%d`", add ? "add" : "del", fd);
-    }
-  return 0;
-}
-
 int
-epoll_helper (int *in_fds, int *in_levelfds, int *out_fds, int *out_levelfds, libcrun_error_t *err)
+epoll_helper (int *in_fds, int *in_edgefds, int *out_fds, int *out_edgefds, libcrun_error_t *err)
 {
   struct epoll_event ev;
   cleanup_close int epollfd = -1;
@@ -1287,69 +1271,101 @@ epoll_helper (int *in_fds, int *in_levelfds, int *out_fds, int *out_levelfds, li
 
   if (in_fds)
     ADD_FDS (in_fds, EPOLLIN);
-  if (in_levelfds)
-    ADD_FDS (in_levelfds, EPOLLIN | EPOLLET);
+  if (in_edgefds)
+    ADD_FDS (in_edgefds, EPOLLIN | EPOLLET);
   if (out_fds)
     ADD_FDS (out_fds, EPOLLOUT);
-  if (out_levelfds)
-    ADD_FDS (out_levelfds, EPOLLOUT | EPOLLET);
+  if (out_edgefds)
+    ADD_FDS (out_edgefds, EPOLLOUT | EPOLLET);
 
   ret = epollfd;
   epollfd = -1;
   return ret;
 }
 
-int
-copy_from_fd_to_fd (int src, int dst, int consume, libcrun_error_t *err)
+/* Size of a transfer when the size of the source is not known.  */
+#define COPY_CHUNK_SIZE (128 * 1024)
+
+enum
 {
-  int ret;
-  ssize_t nread;
-  size_t pagesize = get_page_size ();
+  COPY_WITH_COPY_FILE_RANGE,
+  COPY_WITH_SENDFILE,
+  COPY_WITH_READ_WRITE,
+};
+
+/* Move up to LEN bytes from SRC to DST with the method *HOW, falling back
+   to the next one when the fds do not support it.  The read/write
+   fallback uses *BUFFER, allocated on the first use.  It has the same
+   return value as read(2).  */
+static ssize_t
+copy_chunk_from_fd_to_fd (int src, int dst, size_t len, int *how, char **buffer, size_t *buffer_size)
+{
+  ssize_t nread, remaining;
+
 #ifdef HAVE_COPY_FILE_RANGE
-  bool can_copy_file_range = true;
+  if (*how == COPY_WITH_COPY_FILE_RANGE)
+    {
+      nread = TEMP_FAILURE_RETRY (copy_file_range (src, NULL, dst, NULL, len, 0));
+      if (nread >= 0 || ! (errno == EINVAL || errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP))
+        return nread;
+    }
 #endif
-  do
+  if (*how < COPY_WITH_SENDFILE)
+    *how = COPY_WITH_SENDFILE;
+
+  if (*how == COPY_WITH_SENDFILE)
     {
-      cleanup_free char *buffer = NULL;
-      ssize_t remaining;
+      nread = TEMP_FAILURE_RETRY (sendfile (dst, src, NULL, len));
+      if (nread >= 0 || ! (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+        return nread;
 
-#ifdef HAVE_COPY_FILE_RANGE
-      if (can_copy_file_range)
-        {
-          nread = copy_file_range (src, NULL, dst, NULL, pagesize, 0);
-          if (nread < 0 && (errno == EINVAL || errno == EXDEV))
-            {
-              can_copy_file_range = false;
-              goto fallback;
-            }
-          if (consume && nread < 0 && errno == EAGAIN)
-            return 0;
-          if (nread < 0 && errno == EIO)
-            return 0;
-          if (UNLIKELY (nread < 0))
-            return crun_make_error (err, errno, "copy_file_range");
-          continue;
-        }
-    fallback:
-#endif
+      *how = COPY_WITH_READ_WRITE;
+    }
+
+  if (*buffer == NULL)
+    {
+      *buffer_size = len < COPY_CHUNK_SIZE ? len : COPY_CHUNK_SIZE;
+      *buffer = xmalloc (*buffer_size);
+    }
 
-      buffer = xmalloc (pagesize);
-      nread = TEMP_FAILURE_RETRY (read (src, buffer, pagesize));
+  nread = TEMP_FAILURE_RETRY (read (src, *buffer, len < *buffer_size ? len : *buffer_size));
+  if (nread <= 0)
+    return nread;
+
+  remaining = nread;
+  while (remaining)
+    {
+      ssize_t ret = TEMP_FAILURE_RETRY (write (dst, *buffer + nread - remaining, remaining));
+      if (UNLIKELY (ret < 0))
+        return ret;
+      remaining -= ret;
+    }
+  return nread;
+}
+
+int
+copy_from_fd_to_fd (int src, int dst, int consume, libcrun_error_t *err)
+{
+  cleanup_free char *buffer = NULL;
+  size_t buffer_size = 0;
+  int how = COPY_WITH_COPY_FILE_RANGE;
+  size_t len = COPY_CHUNK_SIZE;
+  struct stat st;
+  ssize_t nread;
+
+  /* Move a regular file with as few calls as possible.  */
+  if (fstat (src, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > COPY_CHUNK_SIZE)
+    len = st.st_size > SSIZE_MAX ? SSIZE_MAX : (size_t) st.st_size;
+
+  do
+    {
+      nread = copy_chunk_from_fd_to_fd (src, dst, len, &how, &buffer, &buffer_size);
       if (consume && nread < 0 && errno == EAGAIN)
         return 0;
       if (nread < 0 && errno == EIO)
         return 0;
       if (UNLIKELY (nread < 0))
-        return crun_make_error (err, errno, "read");
-
-      remaining = nread;
-      while (remaining)
-        {
-          ret = TEMP_FAILURE_RETRY (write (dst, buffer + nread - remaining, remaining));
-          if (UNLIKELY (ret < 0))
-            return crun_make_error (err, errno, "write");
-          remaining -= ret;
-        }
+        return crun_make_error (err, errno, "copy data");
   } while (consume && nread);
 
   return 0;
@@ -1790,6 +1806,201 @@ restore_sig_mask_and_exit:
   return ret;
 }
 
+static int
+get_monotonic_seconds (time_t *out, libcrun_error_t *err)
+{
+  struct timespec ts;
+
+  if (UNLIKELY (clock_gettime (CLOCK_MONOTONIC, &ts) < 0))
+    return crun_make_error (err, errno, "clock_gettime");
+  *out = ts.tv_sec;
+  return 0;
+}
+
+/* Wait for all the PROCESSES to exit, killing the ones that exceed their
+   timeout.  SIGCHLD must be blocked.  */
+static int
+wait_for_processes (struct run_process_s *processes, pid_t *pids, size_t n, libcrun_error_t *err)
+{
+  sigset_t mask;
+  time_t start;
+  int ret;
+
+  sigemptyset (&mask);
+  sigaddset (&mask, SIGCHLD);
+
+  ret = get_monotonic_seconds (&start, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  while (1)
+    {
+      struct timespec ts_timeout = {};
+      bool has_timeout = false;
+      size_t i, running = 0;
+      time_t now;
+
+      ret = get_monotonic_seconds (&now, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      for (i = 0; i < n; i++)
+        {
+          int status;
+
+          if (pids[i] <= 0)
+            continue;
+
+          ret = waitpid_ignore_stopped (pids[i], &status, WNOHANG);
+          if (UNLIKELY (ret < 0))
+            return crun_make_error (err, errno, "waitpid");
+          if (ret > 0)
+            {
+              processes[i].exit_code = get_process_exit_status (status);
+              pids[i] = 0;
+              continue;
+            }
+
+          if (processes[i].timeout > 0)
+            {
+              time_t left = start + processes[i].timeout - now;
+
+              if (left <= 0)
+                {
+                  kill (pids[i], SIGKILL);
+                  TEMP_FAILURE_RETRY (waitpid (pids[i], &status, 0));
+                  processes[i].timed_out = true;
+                  processes[i].exit_code = 128 + SIGKILL;
+                  pids[i] = 0;
+                  continue;
+                }
+              if (! has_timeout || left < ts_timeout.tv_sec)
+                ts_timeout.tv_sec = left;
+              has_timeout = true;
+            }
+          running++;
+        }
+
+      if (running == 0)
+        return 0;
+
+      /* A SIGCHLD could come from any child, so check them all again when
+         it arrives.  */
+      ret = sigtimedwait (&mask, NULL, has_timeout ? &ts_timeout : NULL);
+      if (UNLIKELY (ret < 0 && errno != EAGAIN && errno != EINTR))
+        return crun_make_error (err, errno, "sigtimedwait");
+    }
+}
+
+/* Reopen MEMFD, so that each process reads it from its own offset.  If /proc
+   is not usable, give the process a private copy.  */
+static int
+open_process_stdin (int memfd, char *stdin, size_t stdin_len, libcrun_error_t *err)
+{
+  char stdin_path[64];
+  cleanup_close int fd = -1;
+  int ret;
+
+  snprintf (stdin_path, sizeof (stdin_path), "/proc/self/fd/%d", memfd);
+  ret = open (stdin_path, O_RDONLY | O_CLOEXEC);
+  if (LIKELY (ret >= 0))
+    return ret;
+
+  fd = memfd_create ("hooks-state", MFD_CLOEXEC);
+  if (UNLIKELY (fd < 0))
+    return crun_make_error (err, errno, "memfd_create");
+
+  ret = safe_write (fd, "hooks-state", stdin, stdin_len, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  if (UNLIKELY (lseek (fd, 0, SEEK_SET) < 0))
+    return crun_make_error (err, errno, "lseek");
+
+  ret = fd;
+  fd = -1;
+  return ret;
+}
+
+/* Run all the PROCESSES at the same time and wait for them.  They all read
+   the same STDIN, that is written once to a memfd.  The exit code of each
+   process is stored in its EXIT_CODE field.  It changes the signals mask
+   for the current process.  */
+int
+run_processes_with_stdin_timeout (struct run_process_s *processes, size_t n, const char *cwd, char *stdin,
+                                  size_t stdin_len, int out_fd, int err_fd, libcrun_error_t *err)
+{
+  cleanup_free pid_t *pids = NULL;
+  cleanup_close int memfd = -1;
+  sigset_t oldmask, mask;
+  size_t i;
+  int ret, r;
+
+  memfd = memfd_create ("hooks-state", MFD_CLOEXEC);
+  if (UNLIKELY (memfd < 0))
+    return crun_make_error (err, errno, "memfd_create");
+
+  ret = safe_write (memfd, "hooks-state", stdin, stdin_len, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  sigemptyset (&mask);
+  sigaddset (&mask, SIGCHLD);
+  ret = sigprocmask (SIG_BLOCK, &mask, &oldmask);
+  if (UNLIKELY (ret < 0))
+    return crun_make_error (err, errno, "sigprocmask");
+
+  pids = xmalloc0 (sizeof (pid_t) * n);
+  for (i = 0; i < n; i++)
+    {
+      int stdin_fd;
+
+      processes[i].exit_code = -1;
+      processes[i].timed_out = false;
+
+      stdin_fd = open_process_stdin (memfd, stdin, stdin_len, err);
+      if (UNLIKELY (stdin_fd < 0))
+        {
+          ret = stdin_fd;
+          goto kill_and_exit;
+        }
+
+      pids[i] = fork ();
+      if (UNLIKELY (pids[i] < 0))
+        {
+          ret = crun_make_error (err, errno, "fork");
+          pids[i] = 0;
+          TEMP_FAILURE_RETRY (close (stdin_fd));
+          goto kill_and_exit;
+        }
+
+      if (pids[i] == 0)
+        {
+          /* run_process_child doesn't return.  */
+          run_process_child (processes[i].path, processes[i].args, cwd, processes[i].envp, stdin_fd, -1, out_fd,
+                             err_fd);
+        }
+
+      TEMP_FAILURE_RETRY (close (stdin_fd));
+    }
+
+  ret = wait_for_processes (processes, pids, n, err);
+
+kill_and_exit:
+  /* Cleanup the processes still running after an error.  */
+  for (i = 0; i < n; i++)
+    if (pids[i] > 0)
+      {
+        kill (pids[i], SIGKILL);
+        TEMP_FAILURE_RETRY (waitpid (pids[i], NULL, 0));
+      }
+
+  r = sigprocmask (SIG_SETMASK, &oldmask, NULL);
+  if (UNLIKELY (r < 0 && ret >= 0))
+    ret = crun_make_error (err, errno, "restoring signal mask with sigprocmask");
+  return ret;
+}
+
 int
 mark_or_close_fds_ge_than (libcrun_container_t *container, int n, bool close_now, libcrun_error_t *err)
 {
@@ -2170,6 +2381,13 @@ fallback:
   return ret;
 }
 
+/*
+ * ALLPERMS is not defined by POSIX
+ */
+#ifndef ALLPERMS
+#  define ALLPERMS (S_ISUID | S_ISGID | S_ISVTX | S_IRWXU | S_IRWXG | S_IRWXO)
+#endif
+
 int
 copy_recursive_fd_to_fd (int srcdirfd, int dfd, const char *srcname, const char *destname, libcrun_error_t *err)
 {
@@ -2216,7 +2434,7 @@ copy_recursive_fd_to_fd (int srcdirfd, int dfd, const char *srcname, const char
 
           ret = copy_from_fd_to_fd (srcfd, destfd, 1, err);
           if (UNLIKELY (ret < 0))
-            return ret;
+            return crun_error_wrap (err, "copy `%s/%s`", srcname, de->d_name);
 
 #ifdef HAVE_FGETXATTR
           ret = (int) copy_xattr (srcfd, destfd, de->d_name, de->d_name, err);
@@ -2224,9 +2442,16 @@ copy_recursive_fd_to_fd (int srcdirfd, int dfd, const char *srcname, const char
             return ret;
 #endif
 
-          TEMP_FAILURE_RETRY (close (destfd));
-          destfd = -1;
-          break;
+          /* The file is already open, so set the owner and the mode
+             without resolving the path again.  */
+          ret = fchown (destfd, uid, gid);
+          if (UNLIKELY (ret < 0))
+            return crun_make_error (err, errno, "fchown `%s/%s`", destname, de->d_name);
+
+          ret = fchmod (destfd, mode & ALLPERMS);
+          if (UNLIKELY (ret < 0))
+            return crun_make_error (err, errno, "fchmod `%s/%s`", destname, de->d_name);
+          continue;
 
         case S_IFDIR:
           ret = mkdirat (destdirfd, de->d_name, mode);
@@ -2277,13 +2502,6 @@ copy_recursive_fd_to_fd (int srcdirfd, int dfd, const char *srcname, const char
       if (UNLIKELY (ret < 0))
         return crun_make_error (err, errno, "fchownat `%s/%s`", destname, de->d_name);
 
-      /*
-       * ALLPERMS is not defined by POSIX
-       */
-#ifndef ALLPERMS
-#  define ALLPERMS (S_ISUID | S_ISGID | S_ISVTX | S_IRWXU | S_IRWXG | S_IRWXO)
-#endif
-
       ret = fchmodat (destdirfd, de->d_name, mode & ALLPERMS, AT_SYMLINK_NOFOLLOW);
       if (UNLIKELY (ret < 0))
         {
@@ -2726,23 +2944,48 @@ invalid_input:
 
 struct channel_fd_pair
 {
+  /* Used when the data cannot be moved with splice(2).  */
   struct ring_buffer *rb;
+  size_t size;
+
+  /* The data is moved with splice(2) through this pipe, without copying
+     it to user space.  */
+  int pipe_fds[2];
+  size_t pipe_size;
+  size_t pipe_used;
 
   int in_fd;
   int out_fd;
-
-  int infd_epoll_events;
-  int outfd_epoll_events;
 };
 
 struct channel_fd_pair *
 channel_fd_pair_new (int in_fd, int out_fd, size_t size)
 {
-  struct channel_fd_pair *channel = xmalloc (sizeof (struct channel_fd_pair));
+  struct channel_fd_pair *channel = xmalloc0 (sizeof (struct channel_fd_pair));
+  int ret;
+
   channel->in_fd = in_fd;
   channel->out_fd = out_fd;
-  channel->infd_epoll_events = -1;
-  channel->outfd_epoll_events = -1;
+  channel->size = size;
+  channel->pipe_fds[0] = channel->pipe_fds[1] = -1;
+
+  ret = pipe2 (channel->pipe_fds, O_NONBLOCK | O_CLOEXEC);
+  if (LIKELY (ret == 0))
+    {
+      /* Best effort, the default pipe size is used if it fails.  */
+      (void) fcntl (channel->pipe_fds[1], F_SETPIPE_SZ, (int) size);
+
+      ret = fcntl (channel->pipe_fds[1], F_GETPIPE_SZ);
+      if (LIKELY (ret > 0))
+        {
+          channel->pipe_size = ret;
+          return channel;
+        }
+
+      close_and_reset (&channel->pipe_fds[0]);
+      close_and_reset (&channel->pipe_fds[1]);
+    }
+
   channel->rb = ring_buffer_make (size);
   return channel;
 }
@@ -2753,67 +2996,143 @@ channel_fd_pair_free (struct channel_fd_pair *channel)
   if (channel == NULL)
     return;
 
+  close_and_reset (&channel->pipe_fds[0]);
+  close_and_reset (&channel->pipe_fds[1]);
   ring_buffer_free (channel->rb);
   free (channel);
 }
 
+/* One of the two fds does not support splice(2).  Move what is left in the
+   pipe to a ring buffer and use it from now on.  */
+static int
+channel_fd_pair_fallback_to_ring_buffer (struct channel_fd_pair *channel, libcrun_error_t *err)
+{
+  bool is_eagain = false;
+  int ret;
+
+  channel->rb = ring_buffer_make (channel->size > channel->pipe_used ? channel->size : channel->pipe_used);
+  while (channel->pipe_used > 0)
+    {
+      ret = ring_buffer_read (channel->rb, channel->pipe_fds[0], &is_eagain, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+      if (ret == 0)
+        break;
+      channel->pipe_used -= ret;
+    }
+
+  close_and_reset (&channel->pipe_fds[0]);
+  close_and_reset (&channel->pipe_fds[1]);
+  channel->pipe_used = 0;
+  return 0;
+}
+
+/* Move data with splice(2), it has the same return values as ring_buffer_read
+   and ring_buffer_write.  *UNSUPPORTED is set if one of the fds does not
+   support it.  */
+static int
+channel_fd_pair_splice (int in_fd, int out_fd, size_t len, bool *is_eagain, bool *unsupported, libcrun_error_t *err)
+{
+  ssize_t ret;
+
+  *is_eagain = false;
+  *unsupported = false;
+
+  ret = splice (in_fd, NULL, out_fd, NULL, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  if (UNLIKELY (ret < 0))
+    {
+      if (errno == EIO)
+        return 0;
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+          *is_eagain = true;
+          return 0;
+        }
+      if (errno == EINVAL)
+        {
+          *unsupported = true;
+          return 0;
+        }
+      return crun_make_error (err, errno, "splice");
+    }
+  return ret;
+}
+
+static inline size_t
+channel_fd_pair_get_space_available (struct channel_fd_pair *channel)
+{
+  if (channel->rb)
+    return ring_buffer_get_space_available (channel->rb);
+  return channel->pipe_size - channel->pipe_used;
+}
+
+static inline size_t
+channel_fd_pair_get_data_available (struct channel_fd_pair *channel)
+{
+  if (channel->rb)
+    return ring_buffer_get_data_available (channel->rb);
+  return channel->pipe_used;
+}
+
 int
-channel_fd_pair_process (struct channel_fd_pair *channel, int epollfd, libcrun_error_t *err)
+channel_fd_pair_process (struct channel_fd_pair *channel, libcrun_error_t *err)
 {
   bool is_input_eagain = false, is_output_eagain = false, repeat;
+  bool unsupported = false;
   int ret, i;
 
   /* This function is called from an epoll loop.  Use a hard limit to avoid infinite loops
-     and prevent other events from being processed.  */
+     and prevent other events from being processed.  The fds are registered
+     edge-triggered, so the loop keeps going until both sides would block.  */
   for (i = 0, repeat = true; i < 1000 && repeat; i++)
     {
       repeat = false;
-      if (ring_buffer_get_space_available (channel->rb) > 0)
+      if (channel_fd_pair_get_space_available (channel) > 0)
         {
-          ret = ring_buffer_read (channel->rb, channel->in_fd, &is_input_eagain, err);
+          if (channel->rb)
+            ret = ring_buffer_read (channel->rb, channel->in_fd, &is_input_eagain, err);
+          else
+            {
+              ret = channel_fd_pair_splice (channel->in_fd, channel->pipe_fds[1],
+                                            channel->pipe_size - channel->pipe_used, &is_input_eagain,
+                                            &unsupported, err);
+              if (ret > 0)
+                channel->pipe_used += ret;
+            }
           if (UNLIKELY (ret < 0))
             return ret;
           if (ret > 0)
             repeat = true;
         }
-      if (ring_buffer_get_data_available (channel->rb) > 0)
+      if (! unsupported && channel_fd_pair_get_data_available (channel) > 0)
         {
-          ret = ring_buffer_write (channel->rb, channel->out_fd, &is_output_eagain, err);
+          if (channel->rb)
+            ret = ring_buffer_write (channel->rb, channel->out_fd, &is_output_eagain, err);
+          else
+            {
+              ret = channel_fd_pair_splice (channel->pipe_fds[0], channel->out_fd, channel->pipe_used,
+                                            &is_output_eagain, &unsupported, err);
+              if (ret > 0)
+                channel->pipe_used -= ret;
+            }
           if (UNLIKELY (ret < 0))
             return ret;
           if (ret > 0)
             repeat = true;
         }
-    }
-
-  if (epollfd >= 0)
-    {
-      size_t available = ring_buffer_get_space_available (channel->rb);
-      size_t used = ring_buffer_get_data_available (channel->rb);
-      int events;
-
-      /* If there is space available in the buffer, we want to read more.  */
-      events = (available > 0) ? (EPOLLIN | (is_input_eagain ? EPOLLET : 0)) : 0;
-      if (events != channel->infd_epoll_events)
-        {
-          ret = epoll_helper_toggle (epollfd, channel->in_fd, events, err);
-          if (UNLIKELY (ret < 0))
-            return ret;
-          channel->infd_epoll_events = events;
-        }
-
-      /* If there is data available in the buffer, we want to write as soon as
-         it is possible.  */
-      events = (used > 0) ? (EPOLLOUT | (is_output_eagain ? EPOLLET : 0)) : 0;
-      if (events != channel->outfd_epoll_events)
+      if (UNLIKELY (unsupported))
         {
-          ret = epoll_helper_toggle (epollfd, channel->out_fd, events, err);
+          ret = channel_fd_pair_fallback_to_ring_buffer (channel, err);
           if (UNLIKELY (ret < 0))
             return ret;
-          channel->outfd_epoll_events = events;
+          unsupported = false;
+          repeat = true;
         }
     }
-  return 0;
+
+  /* The limit was hit and there is still work to do.  No new event might
+     be raised for it, so let the caller know it must call again.  */
+  return repeat ? 1 : 0;
 }
 
 int
@@ -335,7 +335,7 @@ int receive_fd_from_socket_with_payload (int from, char *payload, size_t payload
 
 int create_signalfd (sigset_t *mask, libcrun_error_t *err);
 
-int epoll_helper (int *in_fds, int *in_levelfds, int *out_fds, int *out_levelfds, libcrun_error_t *err);
+int epoll_helper (int *in_fds, int *in_edgefds, int *out_fds, int *out_edgefds, libcrun_error_t *err);
 
 int copy_from_fd_to_fd (int src, int dst, int consume, libcrun_error_t *err);
 
@@ -346,6 +346,22 @@ int format_default_id_mapping (char **out, uid_t container_id, uid_t host_uid, u
 int run_process_with_stdin_timeout_envp (char *path, char **args, const char *cwd, int timeout, char **envp,
                                          char *stdin, size_t stdin_len, int out_fd, int err_fd, libcrun_error_t *err);
 
+struct run_process_s
+{
+  char *path;
+  char **args;
+  char **envp;
+  int timeout;
+
+  /* Set by run_processes_with_stdin_timeout.  A process killed for its
+     timeout has TIMED_OUT set and exits with 128 + SIGKILL.  */
+  int exit_code;
+  bool timed_out;
+};
+
+int run_processes_with_stdin_timeout (struct run_process_s *processes, size_t n, const char *cwd, char *stdin,
+                                      size_t stdin_len, int out_fd, int err_fd, libcrun_error_t *err);
+
 int mark_or_close_fds_ge_than (libcrun_container_t *container, int n, bool close_now, libcrun_error_t *err);
 
 void get_current_timestamp (char *out, size_t len);
@@ -501,10 +517,11 @@ void channel_fd_pair_free (struct channel_fd_pair *channel);
 /* Process the data in the channel_fd_pair.  This function will read data from
  * the input file descriptor and write it to the output file descriptor.  If
  * the output file descriptor is not ready to accept the data, the data will be
- * buffered.  If epollfd is provided, the in_fd and out_fd will be registered
- * and unregistered as necessary.
+ * buffered.  It works until both file descriptors would block, so they can be
+ * registered once with EPOLLET and never toggled.  Returns 1 if it stopped
+ * before that point, and it must be called again without waiting for events.
  */
-int channel_fd_pair_process (struct channel_fd_pair *channel, int epollfd, libcrun_error_t *err);
+int channel_fd_pair_process (struct channel_fd_pair *channel, libcrun_error_t *err);
 
 static inline void
 cleanup_channel_fd_pairp (void *p)
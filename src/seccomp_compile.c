@@ -0,0 +1,81 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <argp.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "crun.h"
+#include "libcrun/container.h"
+#include "libcrun/utils.h"
+
+static char doc[] = "OCI runtime";
+
+static struct argp_option options[] = { {
+    0,
+} };
+
+static char args_doc[] = "seccomp-compile [CONFIG]";
+
+static error_t
+parse_opt (int key arg_unused, char *arg arg_unused, struct argp_state *state arg_unused)
+{
+  return ARGP_ERR_UNKNOWN;
+}
+
+static struct argp run_argp = { options, parse_opt, args_doc, doc, NULL, NULL, NULL };
+
+int
+crun_command_seccomp_compile (struct crun_global_arguments *global_args, int argc, char **argv, libcrun_error_t *err)
+{
+  cleanup_container libcrun_container_t *container = NULL;
+  cleanup_free char *checksum = NULL;
+  const char *config_file = "config.json";
+  int first_arg;
+  int ret;
+  libcrun_context_t crun_context = {
+    0,
+  };
+
+  argp_parse (&run_argp, argc, argv, ARGP_IN_ORDER, &first_arg, NULL);
+  crun_assert_n_args (argc - first_arg, 0, 1);
+
+  if (first_arg < argc)
+    config_file = argv[first_arg];
+
+  ret = init_libcrun_context (&crun_context, NULL, global_args, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  container = libcrun_container_load_from_file (config_file, err);
+  if (container == NULL)
+    return -1;
+
+  ret = libcrun_container_seccomp_compile (&crun_context, container, &checksum, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  if (checksum)
+    printf ("%s\n", checksum);
+
+  return 0;
+}
@@ -0,0 +1,606 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <argp.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <yajl/yajl_tree.h>
+#include <yajl/yajl_gen.h>
+
+#include "crun.h"
+#include "libcrun/container.h"
+#include "libcrun/cgroup-utils.h"
+#include "libcrun/utils.h"
+
+static char doc[] = "OCI runtime";
+
+#define YAJL_STR(x) ((const unsigned char *) (x))
+
+/* Maximum size accepted for a single request.  */
+#define SERVE_MAX_REQUEST_SIZE (64 * 1024)
+
+/* Exit status of a pool worker that could not accept a connection.  */
+#define POOL_WORKER_ACCEPT_FAILED 2
+
+/* Give up after this many workers in a row failed to accept a
+   connection.  */
+#define POOL_MAX_ACCEPT_FAILURES 10
+
+enum
+{
+  OPTION_SOCKET_MODE = 1000,
+  OPTION_POOL_SIZE,
+};
+
+struct serve_options_s
+{
+  int socket_mode;
+  int pool_size;
+};
+
+static struct serve_options_s serve_options;
+
+static struct argp_option options[]
+    = { { "socket-mode", OPTION_SOCKET_MODE, "MODE", 0, "permissions for the listening socket (default 0600)", 0 },
+        { "pool-size", OPTION_POOL_SIZE, "N", 0, "number of workers to keep forked and waiting for a request", 0 },
+        {
+            0,
+        } };
+
+static char args_doc[] = "serve SOCKET";
+
+static error_t
+parse_opt (int key, char *arg, struct argp_state *state)
+{
+  char *endptr = NULL;
+
+  switch (key)
+    {
+    case OPTION_SOCKET_MODE:
+      errno = 0;
+      serve_options.socket_mode = (int) strtol (argp_mandatory_argument (arg, state), &endptr, 8);
+      if (errno != 0 || *endptr != '\0')
+        libcrun_fail_with_error (EINVAL, "invalid value for `socket-mode`");
+      break;
+
+    case OPTION_POOL_SIZE:
+      serve_options.pool_size = parse_int_or_fail (argp_mandatory_argument (arg, state), "pool-size");
+      if (serve_options.pool_size < 0)
+        libcrun_fail_with_error (EINVAL, "invalid value for `pool-size`");
+      break;
+
+    case ARGP_KEY_NO_ARGS:
+      libcrun_fail_with_error (0, "please specify the path to the socket");
+
+    default:
+      return ARGP_ERR_UNKNOWN;
+    }
+
+  return 0;
+}
+
+static struct argp run_argp = { options, parse_opt, args_doc, doc, NULL, NULL, NULL };
+
+static void
+sigchld_handler (int signo arg_unused)
+{
+  /* Only used to interrupt accept(2).  */
+}
+
+static void
+reap_children ()
+{
+  while (waitpid (-1, NULL, WNOHANG) > 0)
+    ;
+}
+
+static int
+read_request (int fd, char **out, libcrun_error_t *err)
+{
+  cleanup_free char *buffer = NULL;
+  size_t allocated = 0;
+  size_t used = 0;
+
+  for (;;)
+    {
+      char *nl;
+      ssize_t r;
+
+      if (allocated - used < 512)
+        {
+          allocated += 4096;
+          if (allocated > SERVE_MAX_REQUEST_SIZE)
+            return crun_make_error (err, EMSGSIZE, "request too big");
+          buffer = xrealloc (buffer, allocated);
+        }
+
+      r = TEMP_FAILURE_RETRY (read (fd, buffer + used, allocated - used - 1));
+      if (UNLIKELY (r < 0))
+        return crun_make_error (err, errno, "read request");
+      if (r == 0)
+        break;
+
+      used += r;
+      buffer[used] = '\0';
+
+      /* A request is terminated either by a newline or by EOF.  */
+      nl = memchr (buffer + used - r, '\n', r);
+      if (nl)
+        {
+          *nl = '\0';
+          break;
+        }
+    }
+
+  if (used == 0)
+    return crun_make_error (err, 0, "empty request");
+
+  buffer[used] = '\0';
+  *out = buffer;
+  buffer = NULL;
+  return 0;
+}
+
+static const char *
+get_string (yajl_val tree, const char *key)
+{
+  const char *path[] = { key, NULL };
+  return YAJL_GET_STRING (yajl_tree_get (tree, path, yajl_t_string));
+}
+
+static bool
+get_bool (yajl_val tree, const char *key)
+{
+  const char *path[] = { key, NULL };
+  return YAJL_IS_TRUE (yajl_tree_get (tree, path, yajl_t_any));
+}
+
+static int
+write_all (int fd, const char *buf, size_t len)
+{
+  while (len)
+    {
+      ssize_t r = TEMP_FAILURE_RETRY (write (fd, buf, len));
+      if (r < 0)
+        return r;
+      buf += r;
+      len -= r;
+    }
+  return 0;
+}
+
+static void
+write_response (int fd, int ret, libcrun_error_t *err)
+{
+  const unsigned char *buf = NULL;
+  yajl_gen gen = NULL;
+  size_t len;
+
+  gen = yajl_gen_alloc (NULL);
+  if (gen == NULL)
+    return;
+
+  yajl_gen_map_open (gen);
+  yajl_gen_string (gen, YAJL_STR ("status"), strlen ("status"));
+  yajl_gen_integer (gen, ret);
+  if (ret < 0 && err && *err)
+    {
+      yajl_gen_string (gen, YAJL_STR ("error"), strlen ("error"));
+      yajl_gen_string (gen, YAJL_STR ((*err)->msg), strlen ((*err)->msg));
+      yajl_gen_string (gen, YAJL_STR ("errno"), strlen ("errno"));
+      yajl_gen_integer (gen, (*err)->status);
+    }
+  yajl_gen_map_close (gen);
+
+  if (yajl_gen_get_buf (gen, &buf, &len) == yajl_gen_status_ok)
+    {
+      (void) write_all (fd, (const char *) buf, len);
+      (void) write_all (fd, "\n", 1);
+    }
+
+  yajl_gen_free (gen);
+}
+
+static int
+handle_create_or_run (libcrun_context_t *context, yajl_val tree, bool run, libcrun_error_t *err)
+{
+  cleanup_container libcrun_container_t *container = NULL;
+  const char *config_file = get_string (tree, "config");
+  const char *bundle = get_string (tree, "bundle");
+
+  if (bundle == NULL || bundle[0] != '/')
+    return crun_make_error (err, EINVAL, "`bundle` must be an absolute path");
+
+  if (config_file == NULL)
+    config_file = "config.json";
+
+  if (chdir (bundle) < 0)
+    return crun_make_error (err, errno, "chdir `%s` failed", bundle);
+
+  context->bundle = bundle;
+  context->console_socket = get_string (tree, "console-socket");
+  context->pid_file = get_string (tree, "pid-file");
+  context->no_new_keyring = get_bool (tree, "no-new-keyring");
+  context->no_pivot = get_bool (tree, "no-pivot");
+  /* The server never waits for the container, it is always detached.  */
+  context->detach = true;
+
+  container = libcrun_container_load_from_file (config_file, err);
+  if (container == NULL)
+    return -1;
+
+  if (run)
+    return libcrun_container_run (context, container, 0, err);
+
+  return libcrun_container_create (context, container, 0, err);
+}
+
+static int
+handle_exec (libcrun_context_t *context, yajl_val tree, libcrun_error_t *err)
+{
+  struct libcrun_container_exec_options_s exec_opts;
+  const char *process = get_string (tree, "process");
+
+  if (process == NULL)
+    return crun_make_error (err, EINVAL, "`process` must be specified");
+
+  memset (&exec_opts, 0, sizeof (exec_opts));
+  exec_opts.struct_size = sizeof (exec_opts);
+  exec_opts.path = process;
+  exec_opts.cgroup = get_string (tree, "cgroup");
+
+  context->console_socket = get_string (tree, "console-socket");
+  context->pid_file = get_string (tree, "pid-file");
+  context->detach = true;
+
+  return libcrun_container_exec_with_options (context, context->id, &exec_opts, err);
+}
+
+static int
+handle_state (int fd, libcrun_context_t *context, bool *replied, libcrun_error_t *err)
+{
+  cleanup_free char *buffer = NULL;
+  size_t len = 0;
+  FILE *out;
+  int ret;
+
+  out = open_memstream (&buffer, &len);
+  if (UNLIKELY (out == NULL))
+    return crun_make_error (err, errno, "open_memstream");
+
+  ret = libcrun_container_state (context, context->id, out, err);
+  fclose (out);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  /* On success the state object is the reply.  */
+  *replied = true;
+  if (UNLIKELY (write_all (fd, buffer, len) < 0 || write_all (fd, "\n", 1) < 0))
+    return crun_make_error (err, errno, "write state");
+
+  return 0;
+}
+
+static int
+handle_request (int fd, libcrun_context_t *context, libcrun_error_t *err)
+{
+  cleanup_free char *request = NULL;
+  const char *command;
+  const char *id;
+  yajl_val tree = NULL;
+  bool replied = false;
+  char errbuf[256];
+  int ret;
+
+  ret = read_request (fd, &request, err);
+  if (UNLIKELY (ret < 0))
+    goto exit;
+
+  tree = yajl_tree_parse (request, errbuf, sizeof (errbuf));
+  if (UNLIKELY (tree == NULL))
+    {
+      ret = crun_make_error (err, 0, "cannot parse request: %s", errbuf);
+      goto exit;
+    }
+
+  command = get_string (tree, "command");
+  id = get_string (tree, "id");
+  if (command == NULL || id == NULL)
+    {
+      ret = crun_make_error (err, EINVAL, "both `command` and `id` must be specified");
+      goto exit;
+    }
+
+  context->id = id;
+
+  if (strcmp (command, "create") == 0)
+    ret = handle_create_or_run (context, tree, false, err);
+  else if (strcmp (command, "run") == 0)
+    ret = handle_create_or_run (context, tree, true, err);
+  else if (strcmp (command, "start") == 0)
+    ret = libcrun_container_start (context, id, err);
+  else if (strcmp (command, "exec") == 0)
+    ret = handle_exec (context, tree, err);
+  else if (strcmp (command, "kill") == 0)
+    {
+      const char *signal = get_string (tree, "signal");
+
+      if (signal == NULL)
+        signal = "SIGTERM";
+
+      if (get_bool (tree, "all"))
+        ret = libcrun_container_killall (context, id, signal, err);
+      else
+        ret = libcrun_container_kill (context, id, signal, err);
+    }
+  else if (strcmp (command, "delete") == 0)
+    ret = libcrun_container_delete (context, NULL, id, get_bool (tree, "force"), err);
+  else if (strcmp (command, "state") == 0)
+    ret = handle_state (fd, context, &replied, err);
+  else
+    ret = crun_make_error (err, EINVAL, "unknown command `%s`", command);
+
+exit:
+  if (! replied)
+    write_response (fd, ret < 0 ? ret : 0, err);
+
+  if (tree)
+    yajl_tree_free (tree);
+  return ret;
+}
+
+static void __attribute__ ((noreturn))
+serve_connection (int fd, libcrun_context_t *context)
+{
+  libcrun_error_t err = NULL;
+  struct sigaction act = {};
+  int ret;
+
+  act.sa_handler = SIG_DFL;
+  sigaction (SIGCHLD, &act, NULL);
+
+  ret = handle_request (fd, context, &err);
+  if (UNLIKELY (ret < 0))
+    crun_error_release (&err);
+
+  close (fd);
+  _exit (ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+static int
+serve_with_fork (int listen_fd, libcrun_context_t *context, libcrun_error_t *err)
+{
+  struct sigaction act = {};
+
+  /* Do not set SA_RESTART so that accept(2) is interrupted and the
+     terminated workers are reaped.  */
+  act.sa_handler = sigchld_handler;
+  sigemptyset (&act.sa_mask);
+  if (UNLIKELY (sigaction (SIGCHLD, &act, NULL) < 0))
+    return crun_make_error (err, errno, "sigaction");
+
+  for (;;)
+    {
+      int fd;
+      pid_t pid;
+
+      reap_children ();
+
+      fd = accept4 (listen_fd, NULL, NULL, SOCK_CLOEXEC);
+      if (UNLIKELY (fd < 0))
+        {
+          if (errno == EINTR || errno == ECONNABORTED)
+            continue;
+          return crun_make_error (err, errno, "accept");
+        }
+
+      pid = fork ();
+      if (UNLIKELY (pid < 0))
+        {
+          libcrun_error_t tmp_err = NULL;
+
+          crun_make_error (&tmp_err, errno, "fork");
+          write_response (fd, -1, &tmp_err);
+          crun_error_release (&tmp_err);
+          close (fd);
+          continue;
+        }
+
+      if (pid == 0)
+        {
+          close (listen_fd);
+          serve_connection (fd, context);
+        }
+
+      close (fd);
+    }
+
+  return 0;
+}
+
+static pid_t
+spawn_pool_worker (int listen_fd, libcrun_context_t *context)
+{
+  pid_t ppid = getpid ();
+  pid_t pid;
+  int fd;
+
+  pid = fork ();
+  if (pid != 0)
+    return pid;
+
+  /* Do not leave idle workers around when the server terminates.  */
+  prctl (PR_SET_PDEATHSIG, SIGKILL);
+  if (getppid () != ppid)
+    _exit (EXIT_FAILURE);
+
+  /* The worker is already forked when the connection arrives, so the
+     fork(2) cost is not paid on the request path.  Each worker serves
+     exactly one request and exits.  */
+  for (;;)
+    {
+      fd = accept4 (listen_fd, NULL, NULL, SOCK_CLOEXEC);
+      if (fd >= 0)
+        break;
+      if (errno != EINTR && errno != ECONNABORTED)
+        _exit (POOL_WORKER_ACCEPT_FAILED);
+    }
+
+  /* A request that was accepted is always completed.  */
+  prctl (PR_SET_PDEATHSIG, 0);
+
+  close (listen_fd);
+  serve_connection (fd, context);
+}
+
+static int
+serve_with_pool (int listen_fd, libcrun_context_t *context, int pool_size, libcrun_error_t *err)
+{
+  int accept_failures = 0;
+  int workers = 0;
+
+  for (;;)
+    {
+      int status = 0;
+      pid_t pid;
+
+      /* Do not respawn the workers back to back if accept(2) keeps
+         failing, back off and eventually give up.  */
+      if (accept_failures > 0)
+        {
+          if (accept_failures >= POOL_MAX_ACCEPT_FAILURES)
+            return crun_make_error (err, 0, "the workers cannot accept connections, %d failures in a row",
+                                    accept_failures);
+          usleep (accept_failures * 100000);
+        }
+
+      while (workers < pool_size)
+        {
+          pid = spawn_pool_worker (listen_fd, context);
+          if (UNLIKELY (pid < 0))
+            {
+              /* Keep serving with the workers that are left.  */
+              if (workers > 0)
+                break;
+              return crun_make_error (err, errno, "fork");
+            }
+          workers++;
+        }
+
+      pid = waitpid (-1, &status, 0);
+      if (pid > 0)
+        {
+          workers--;
+          if (WIFEXITED (status) && WEXITSTATUS (status) == POOL_WORKER_ACCEPT_FAILED)
+            accept_failures++;
+          else
+            accept_failures = 0;
+        }
+      else if (errno == ECHILD)
+        workers = 0;
+      else if (errno != EINTR)
+        return crun_make_error (err, errno, "waitpid");
+    }
+
+  return 0;
+}
+
+static int
+open_serve_socket (const char *socket_path, int mode, libcrun_error_t *err)
+{
+  struct stat st;
+  mode_t old_umask;
+  int fd;
+
+  /* Replace a stale socket, but never anything else.  */
+  if (lstat (socket_path, &st) == 0)
+    {
+      if (! S_ISSOCK (st.st_mode))
+        return crun_make_error (err, EEXIST, "`%s` exists and it is not a socket", socket_path);
+      if (UNLIKELY (unlink (socket_path) < 0))
+        return crun_make_error (err, errno, "unlink `%s`", socket_path);
+    }
+  else if (errno != ENOENT)
+    return crun_make_error (err, errno, "lstat `%s`", socket_path);
+
+  /* The socket is created by bind(2) with the permissions allowed by the
+     umask, so it is never reachable with a mode wider than MODE.  */
+  old_umask = umask (~mode & 0777);
+  fd = open_unix_domain_socket (socket_path, 0, err);
+  umask (old_umask);
+
+  return fd;
+}
+
+int
+crun_command_serve (struct crun_global_arguments *global_args, int argc, char **argv, libcrun_error_t *err)
+{
+  int first_arg = 0, ret;
+  cleanup_close int listen_fd = -1;
+  const char *socket_path;
+  libcrun_context_t crun_context = {
+    0,
+  };
+
+  serve_options.socket_mode = 0600;
+
+  argp_parse (&run_argp, argc, argv, ARGP_IN_ORDER, &first_arg, &serve_options);
+  crun_assert_n_args (argc - first_arg, 1, 1);
+
+  socket_path = argv[first_arg];
+
+  /* Pay the fixed initialization cost only once.  The handler manager,
+     the cgroup mode and the LSM detection are cached and inherited by
+     every forked worker.  */
+  ret = init_libcrun_context (&crun_context, NULL, global_args, err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = libcrun_get_cgroup_mode (err);
+  if (UNLIKELY (ret < 0))
+    return ret;
+
+  ret = libcrun_initialize_apparmor (err);
+  if (UNLIKELY (ret < 0))
+    crun_error_release (err);
+
+  listen_fd = open_serve_socket (socket_path, serve_options.socket_mode, err);
+  if (UNLIKELY (listen_fd < 0))
+    return listen_fd;
+
+  /* open_unix_domain_socket uses a backlog of 1, allow for bursts.  */
+  if (UNLIKELY (listen (listen_fd, SOMAXCONN) < 0))
+    return crun_make_error (err, errno, "listen on socket");
+
+  if (serve_options.pool_size > 0)
+    return serve_with_pool (listen_fd, &crun_context, serve_options.pool_size, err);
+
+  return serve_with_fork (listen_fd, &crun_context, err);
+}
@@ -129,7 +129,7 @@ static struct argp_option options[]
             0,
         } };
 
-static char args_doc[] = "update [OPTION]... CONTAINER";
+static char args_doc[] = "update [OPTION]... CONTAINER...";
 
 static error_t
 parse_opt (int key, char *arg, struct argp_state *state)
@@ -180,25 +180,50 @@ static struct argp run_argp = { options, parse_opt, args_doc, doc, NULL, NULL, N
 int
 crun_command_update (struct crun_global_arguments *global_args, int argc, char **argv, libcrun_error_t *err)
 {
-  int first_arg = 0, ret;
+  int first_arg = 0, ret, i, n;
+  const char **ids;
 
   argp_parse (&run_argp, argc, argv, ARGP_IN_ORDER, &first_arg, &crun_context);
-  crun_assert_n_args (argc - first_arg, 1, 1);
+  crun_assert_n_args (argc - first_arg, 1, -1);
 
   ret = init_libcrun_context (&crun_context, argv[first_arg], global_args, err);
   if (UNLIKELY (ret < 0))
     return ret;
 
+  n = argc - first_arg;
+  ids = (const char **) &argv[first_arg];
+
   if (resources == NULL)
     {
-      ret = libcrun_container_update_from_values (&crun_context, argv[first_arg], values, values_len, err);
+      if (n == 1)
+        ret = libcrun_container_update_from_values (&crun_context, ids[0], values, values_len, err);
+      else
+        ret = libcrun_container_update_many_from_values (&crun_context, ids, n, values, values_len, err);
       free (values);
       if (ret < 0)
         return ret;
     }
+  else if (n == 1)
+    {
+      ret = libcrun_container_update_from_file (&crun_context, ids[0], resources, err);
+      if (ret < 0)
+        return ret;
+    }
   else
     {
-      ret = libcrun_container_update_from_file (&crun_context, argv[first_arg], resources, err);
+      cleanup_free const char **contents = NULL;
+      cleanup_free char *content = NULL;
+      size_t len;
+
+      ret = read_all_file (resources, &content, &len, err);
+      if (UNLIKELY (ret < 0))
+        return ret;
+
+      contents = xmalloc0 (sizeof (*contents) * (n + 1));
+      for (i = 0; i < n; i++)
+        contents[i] = content;
+
+      ret = libcrun_container_update_many (&crun_context, ids, contents, n, err);
       if (ret < 0)
         return ret;
     }
@@ -210,9 +235,12 @@ crun_command_update (struct crun_global_arguments *global_args, int argc, char *
         .mem_bw_schema = mem_bw_schema,
       };
 
-      ret = libcrun_container_update_intel_rdt (&crun_context, argv[first_arg], &update, err);
-      if (ret < 0)
-        return ret;
+      for (i = 0; i < n; i++)
+        {
+          ret = libcrun_container_update_intel_rdt (&crun_context, ids[i], &update, err);
+          if (ret < 0)
+            return ret;
+        }
     }
 
   return 0;
@@ -0,0 +1,162 @@
+#!/bin/env python3
+# crun - OCI runtime written in C
+#
+# Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+# crun is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# crun is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with crun.  If not, see <http://www.gnu.org/licenses/>.
+
+# Measure the latency of the container lifecycle: create, start, exec and
+# delete are timed separately for every container, for each combination of
+# cgroup manager, user namespace and seccomp.  The results are printed as
+# JSON, so they can be compared between two builds.
+#
+# Usage: OCI_RUNTIME=./crun INIT=tests/init bench.py [-n ITERATIONS] [-o FILE] [VARIANT...]
+
+import argparse
+import itertools
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+from tests_utils import *
+
+PHASES = ["create", "start", "exec", "delete"]
+
+def variant_name(cgroup_manager, userns, seccomp):
+    return "%s%s%s" % (cgroup_manager, "-userns" if userns else "", "-seccomp" if seccomp else "")
+
+def all_variants():
+    for cgroup_manager, userns, seccomp in itertools.product(["cgroupfs", "systemd"], [False, True], [False, True]):
+        yield variant_name(cgroup_manager, userns, seccomp), (cgroup_manager, userns, seccomp)
+
+def make_config(userns, seccomp):
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'pause']
+    add_all_namespaces(conf, userns=userns)
+    if userns:
+        mapping = [
+            {
+                "containerID": 0,
+                "hostID": 1,
+                "size": 65536
+            }
+        ]
+        conf['linux']['uidMappings'] = mapping
+        conf['linux']['gidMappings'] = mapping
+    if seccomp:
+        conf['linux']['seccomp'] = {
+            'defaultAction': 'SCMP_ACT_ALLOW',
+            'syscalls': [
+                {
+                    'action': 'SCMP_ACT_ERRNO',
+                    'names': ['kexec_load', 'open_by_handle_at', 'init_module', 'reboot']
+                }
+            ]
+        }
+    return conf
+
+def make_bundle(root, conf):
+    bundle = tempfile.mkdtemp(dir=root)
+    rootfs = os.path.join(bundle, "rootfs")
+    for i in ["proc", "sys", "dev", "etc"]:
+        os.makedirs(os.path.join(rootfs, i))
+    shutil.copy2(get_init_path(), os.path.join(rootfs, "init"))
+    if 'uidMappings' in conf['linux']:
+        for r, dirs, files in os.walk(bundle):
+            for f in dirs + files:
+                os.chown(os.path.join(r, f), 1, 1, follow_symlinks=False)
+        os.chown(bundle, 1, 1)
+    with open(os.path.join(bundle, "config.json"), "w") as f:
+        json.dump(conf, f)
+    return bundle
+
+def timed(args, cwd=None):
+    start = time.monotonic()
+    subprocess.check_output(args, cwd=cwd, stderr=subprocess.STDOUT, stdin=subprocess.DEVNULL)
+    return time.monotonic() - start
+
+def percentile(values, p):
+    values = sorted(values)
+    k = (len(values) - 1) * p / 100.0
+    lo = int(k)
+    hi = min(lo + 1, len(values) - 1)
+    return values[lo] + (values[hi] - values[lo]) * (k - lo)
+
+def run_variant(root, name, cgroup_manager, userns, seccomp, iterations):
+    crun = [get_crun_path(), "--cgroup-manager", cgroup_manager, "--root", os.path.join(root, "state")]
+    bundle = make_bundle(root, make_config(userns, seccomp))
+    samples = {phase: [] for phase in PHASES}
+
+    start = time.monotonic()
+    for i in range(iterations):
+        cid = "bench-%s-%d-%d" % (name, os.getpid(), i)
+        try:
+            samples["create"].append(timed(crun + ["create", cid], cwd=bundle))
+            samples["start"].append(timed(crun + ["start", cid]))
+            samples["exec"].append(timed(crun + ["exec", cid, "/init", "true"]))
+            samples["delete"].append(timed(crun + ["delete", "-f", cid]))
+        except subprocess.CalledProcessError as e:
+            subprocess.call(crun + ["delete", "-f", cid], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+            return {"error": e.output.decode('utf-8', errors='ignore').strip()}
+    elapsed = time.monotonic() - start
+
+    result = {"iterations": iterations, "containers_per_second": iterations / elapsed, "phases": {}}
+    for phase in PHASES:
+        values = samples[phase]
+        result["phases"][phase] = {
+            "p50_ms": percentile(values, 50) * 1000,
+            "p99_ms": percentile(values, 99) * 1000,
+            "mean_ms": sum(values) / len(values) * 1000,
+        }
+    return result
+
+def main():
+    parser = argparse.ArgumentParser(description="benchmark the container lifecycle")
+    parser.add_argument("-n", "--iterations", type=int, default=1000)
+    parser.add_argument("-o", "--output", help="write the JSON results to this file")
+    parser.add_argument("variants", nargs="*", help="variants to run, e.g. cgroupfs-userns (default: all)")
+    args = parser.parse_args()
+
+    variants = dict(all_variants())
+    selected = args.variants or list(variants.keys())
+    for name in selected:
+        if name not in variants:
+            sys.stderr.write("unknown variant `%s`, known variants: %s\n" % (name, ", ".join(variants)))
+            return 1
+
+    os.umask(0o22)
+    root = tempfile.mkdtemp(prefix="crun-bench-")
+    results = {"runtime": get_crun_path(), "variants": {}}
+    try:
+        for name in selected:
+            cgroup_manager, userns, seccomp = variants[name]
+            if cgroup_manager == "systemd" and not running_on_systemd():
+                results["variants"][name] = {"skipped": "not running on systemd"}
+                continue
+            sys.stderr.write("# %s\n" % name)
+            results["variants"][name] = run_variant(root, name, cgroup_manager, userns, seccomp, args.iterations)
+    finally:
+        shutil.rmtree(root, ignore_errors=True)
+
+    out = json.dumps(results, indent=2)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(out + "\n")
+    print(out)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,247 @@
+/*
+ * crun - OCI runtime written in C
+ *
+ * Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+ * crun is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * crun is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with crun.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include <libcrun/container.h>
+#include <libcrun/mount_flags.h>
+#include <libcrun/ring_buffer.h>
+#include <libcrun/seccomp.h>
+#include <libcrun/string_map.h>
+#include <libcrun/utils.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Microbenchmarks for the helpers used on every container creation.  Each
+   benchmark runs a fixed number of iterations so that the results of two
+   builds can be compared, and the results are printed as JSON.
+
+   Usage: bench_libcrun [NAME...]  */
+
+#define N_ANNOTATIONS 64
+#define N_SYSCALL_RULES 128
+
+static libcrun_container_t *container;
+static int dev_zero = -1;
+static int dev_null = -1;
+static struct ring_buffer *rb;
+
+/* Prevent the compiler from optimizing away the lookups.  */
+static volatile unsigned long sink;
+
+static const char *mount_options[] = { "ro", "rw", "nosuid", "nodev", "noexec", "rbind", "rprivate",
+                                       "relatime", "strictatime", "mode=755", "size=65536k", "idmap",
+                                       "tmpcopyup", "not-a-flag" };
+
+static const char *signal_names[] = { "SIGKILL", "TERM", "SIGHUP", "SIGRTMIN+3", "USR1", "SIGWINCH", "42" };
+
+static const char *annotation_names[] = { "run.oci.hooks.stdout", "run.oci.keep_original_groups",
+                                          "io.kubernetes.cri.container-type", "annotation.32", "annotation.63",
+                                          "not.an.annotation" };
+
+#define N_ELEMENTS(x) (sizeof (x) / sizeof (x[0]))
+
+static int
+bench_mount_flags (size_t iterations)
+{
+  size_t i;
+
+  for (i = 0; i < iterations; i++)
+    sink += (unsigned long) libcrun_str2mount_flags (mount_options[i % N_ELEMENTS (mount_options)]);
+  return 0;
+}
+
+static int
+bench_signals (size_t iterations)
+{
+  size_t i;
+
+  for (i = 0; i < iterations; i++)
+    sink += str2sig (signal_names[i % N_ELEMENTS (signal_names)]);
+  return 0;
+}
+
+static int
+bench_string_map (size_t iterations)
+{
+  size_t i;
+
+  for (i = 0; i < iterations; i++)
+    sink += (unsigned long) find_string_map_value (container->annotations,
+                                                   annotation_names[i % N_ELEMENTS (annotation_names)]);
+  return 0;
+}
+
+static int
+bench_seccomp_checksum (size_t iterations)
+{
+  seccomp_checksum_t checksum;
+  libcrun_error_t err = NULL;
+  size_t i;
+  int ret;
+
+  for (i = 0; i < iterations; i++)
+    {
+      ret = calculate_seccomp_checksum (container->container_def->linux->seccomp, 0, checksum, &err);
+      if (ret < 0)
+        {
+          crun_error_release (&err);
+          return -1;
+        }
+      sink += checksum[0];
+    }
+  return 0;
+}
+
+static int
+bench_ring_buffer (size_t iterations)
+{
+  libcrun_error_t err = NULL;
+  bool is_eagain;
+  size_t i;
+  int ret;
+
+  for (i = 0; i < iterations; i++)
+    {
+      ret = ring_buffer_read (rb, dev_zero, &is_eagain, &err);
+      if (ret >= 0)
+        ret = ring_buffer_write (rb, dev_null, &is_eagain, &err);
+      if (ret < 0)
+        {
+          crun_error_release (&err);
+          return -1;
+        }
+    }
+  return 0;
+}
+
+struct benchmark
+{
+  const char *name;
+  int (*run) (size_t iterations);
+  size_t iterations;
+};
+
+static struct benchmark benchmarks[] = {
+  { "mount_flags", bench_mount_flags, 10000000 },
+  { "signals", bench_signals, 10000000 },
+  { "string_map", bench_string_map, 10000000 },
+  { "seccomp_checksum", bench_seccomp_checksum, 20000 },
+  { "ring_buffer", bench_ring_buffer, 200000 },
+};
+
+static char *
+generate_config ()
+{
+  char *buffer = NULL;
+  size_t size = 0;
+  FILE *stream;
+  int i;
+
+  stream = open_memstream (&buffer, &size);
+  if (stream == NULL)
+    return NULL;
+
+  fprintf (stream, "{\"ociVersion\": \"1.0.0\", \"root\": {\"path\": \"rootfs\"}, \"annotations\": {");
+  fprintf (stream, "\"run.oci.hooks.stdout\": \"/dev/null\", \"io.kubernetes.cri.container-type\": \"container\"");
+  for (i = 0; i < N_ANNOTATIONS; i++)
+    fprintf (stream, ", \"annotation.%d\": \"value-%d\"", i, i);
+  fprintf (stream, "}, \"linux\": {\"seccomp\": {\"defaultAction\": \"SCMP_ACT_ERRNO\", "
+                   "\"architectures\": [\"SCMP_ARCH_X86_64\", \"SCMP_ARCH_X86\"], \"syscalls\": [");
+  for (i = 0; i < N_SYSCALL_RULES; i++)
+    fprintf (stream, "%s{\"names\": [\"syscall_%d\", \"other_syscall_%d\"], \"action\": \"SCMP_ACT_ALLOW\", "
+                     "\"args\": [{\"index\": 0, \"value\": %d, \"op\": \"SCMP_CMP_EQ\"}]}",
+             i ? ", " : "", i, i, i);
+  fprintf (stream, "]}}}");
+
+  if (fclose (stream) != 0)
+    return NULL;
+  return buffer;
+}
+
+static bool
+is_selected (const char *name, int argc, char **argv)
+{
+  int i;
+
+  if (argc < 2)
+    return true;
+  for (i = 1; i < argc; i++)
+    if (strcmp (argv[i], name) == 0)
+      return true;
+  return false;
+}
+
+int
+main (int argc, char **argv)
+{
+  cleanup_free char *config = NULL;
+  libcrun_error_t err = NULL;
+  bool first = true;
+  size_t i;
+
+  config = generate_config ();
+  if (config == NULL)
+    return EXIT_FAILURE;
+
+  container = libcrun_container_load_from_memory (config, &err);
+  if (container == NULL)
+    {
+      fprintf (stderr, "cannot load the configuration: %s\n", err->msg);
+      return EXIT_FAILURE;
+    }
+
+  dev_zero = open ("/dev/zero", O_RDONLY | O_CLOEXEC);
+  dev_null = open ("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (dev_zero < 0 || dev_null < 0)
+    return EXIT_FAILURE;
+  rb = ring_buffer_make (BUFSIZ);
+
+  printf ("{\"benchmarks\": [");
+  for (i = 0; i < N_ELEMENTS (benchmarks); i++)
+    {
+      struct timespec start, end;
+      double ns;
+
+      if (! is_selected (benchmarks[i].name, argc, argv))
+        continue;
+
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      if (benchmarks[i].run (benchmarks[i].iterations) < 0)
+        {
+          fprintf (stderr, "benchmark `%s` failed\n", benchmarks[i].name);
+          return EXIT_FAILURE;
+        }
+      clock_gettime (CLOCK_MONOTONIC, &end);
+
+      ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+      printf ("%s\n  {\"name\": \"%s\", \"iterations\": %zu, \"total_ms\": %.3f, \"ns_per_op\": %.2f}", first ? "" : ",",
+              benchmarks[i].name, benchmarks[i].iterations, ns / 1e6, ns / benchmarks[i].iterations);
+      first = false;
+    }
+  printf ("\n]}\n");
+
+  ring_buffer_free (rb);
+  close (dev_zero);
+  close (dev_null);
+  libcrun_container_free (container);
+  return EXIT_SUCCESS;
+}
@@ -96,6 +96,58 @@ def test_multiple_containers_delete():
             return -1
     return 0
 
+def test_delete_binary_status():
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'pause']
+    add_all_namespaces(conf)
+
+    out, container_id = run_and_get_output(conf, detach=True, hide_stderr=True, global_args=['--status-format', 'binary'])
+    if out != "":
+        return -1
+    try:
+        status_dir = os.path.join(get_tests_root_status(), container_id)
+        if not os.path.exists(os.path.join(status_dir, "status.bin")):
+            return -1
+        if os.path.exists(os.path.join(status_dir, "status")):
+            return -1
+        # the default json format must still find the container
+        state = json.loads(run_crun_command(["state", container_id]))
+        if state['status'] != "running" or state['id'] != container_id:
+            return -1
+        containers = json.loads(run_crun_command(["list", "--format", "json"]))
+        if container_id not in [c['id'] for c in containers]:
+            return -1
+    finally:
+        run_crun_command(["delete", "-f", container_id])
+    if os.path.exists(os.path.join(get_tests_root_status(), container_id)):
+        return -1
+    return 0
+
+def test_list_invalid_status():
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'pause']
+    add_all_namespaces(conf)
+
+    out, container_id = run_and_get_output(conf, detach=True, hide_stderr=True)
+    if out != "":
+        return -1
+    try:
+        # Entries that cannot be read are skipped, whatever their position
+        # in the directory.
+        for i in range(5):
+            d = os.path.join(get_tests_root_status(), "invalid-%d" % i)
+            os.makedirs(d)
+            with open(os.path.join(d, "status"), "w") as f:
+                f.write("{not json")
+        containers = json.loads(run_crun_command(["list", "--format", "json"]))
+        if [c['id'] for c in containers] != [container_id]:
+            return -1
+    finally:
+        run_crun_command(["delete", "-f", container_id])
+        for i in range(5):
+            shutil.rmtree(os.path.join(get_tests_root_status(), "invalid-%d" % i), ignore_errors=True)
+    return 0
+
 def test_help_delete():
     out = run_crun_command(["delete", "--help"])
     if "Usage: crun [OPTION...] delete CONTAINER" not in out:
@@ -107,6 +159,8 @@ all_tests = {
     "test_simple_delete" : test_simple_delete,
     "test_multiple_containers_delete" : test_multiple_containers_delete,
     "test_help_delete": test_help_delete,
+    "test_delete_binary_status": test_delete_binary_status,
+    "test_list_invalid_status": test_list_invalid_status,
 }
 
 if __name__ == "__main__":
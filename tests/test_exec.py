@@ -539,6 +539,98 @@ def test_exec_error_propagation():
                 sys.stderr.write("# warning: failed to cleanup container %s: %s\n" % (cid, str(cleanup_e)))
     return 0
 
+def test_exec_config_digest():
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'pause']
+    conf['process']['env'].append('FROM_CONFIG=1')
+    add_all_namespaces(conf)
+    cid = None
+    try:
+        _, cid = run_and_get_output(conf, command='run', detach=True)
+
+        exec_config = os.path.join(get_tests_root_status(), cid, "exec.json")
+        with open(exec_config) as f:
+            digest = json.load(f)
+        if 'mounts' in digest or 'resources' in digest.get('linux', {}):
+            sys.stderr.write("# exec.json contains unused data\n")
+            return -1
+
+        # The process defaults still come from the container config.
+        out = run_crun_command(["exec", cid, "/init", "printenv", "FROM_CONFIG"])
+        if "1" not in out:
+            sys.stderr.write("# wrong output from exec: %s\n" % out)
+            return -1
+    finally:
+        if cid is not None:
+            run_crun_command(["delete", "-f", cid])
+    return 0
+
+def test_exec_batch():
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'pause']
+    add_all_namespaces(conf)
+    cid = None
+    temp_dir = tempfile.mkdtemp(dir=get_tests_root())
+    try:
+        _, cid = run_and_get_output(conf, command='run', detach=True)
+
+        batch = []
+        for i in range(4):
+            batch.append({'args': ['/init', 'true'], 'cwd': '/', 'env': ['PATH=/bin']})
+        batch_file = os.path.join(temp_dir, "batch.json")
+        with open(batch_file, "w") as f:
+            json.dump(batch, f)
+        run_crun_command(["exec", "--batch", batch_file, cid])
+
+        # The exit code of the failed process is reported.
+        batch.append({'args': ['/init', 'cat', '/does-not-exist'], 'cwd': '/', 'env': ['PATH=/bin']})
+        with open(batch_file, "w") as f:
+            json.dump(batch, f)
+        try:
+            run_crun_command(["exec", "--batch", batch_file, cid])
+            sys.stderr.write("# the failure of a process in the batch was not reported\n")
+            return -1
+        except subprocess.CalledProcessError:
+            pass
+    finally:
+        if cid is not None:
+            run_crun_command(["delete", "-f", cid])
+        shutil.rmtree(temp_dir)
+    return 0
+
+def test_exec_batch_rlimits():
+    if is_rootless():
+        return 77
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'pause']
+    add_all_namespaces(conf)
+    cid = None
+    temp_dir = tempfile.mkdtemp(dir=get_tests_root())
+    try:
+        _, cid = run_and_get_output(conf, command='run', detach=True)
+
+        # The rlimits of a process must not leak to the next ones in the
+        # batch.
+        batch = [
+            {'args': ['/init', 'cat', '/proc/self/limits'], 'cwd': '/', 'env': ['PATH=/bin'],
+             'rlimits': [{'type': 'RLIMIT_NOFILE', 'soft': 100, 'hard': 200}]},
+            {'args': ['/init', 'cat', '/proc/self/limits'], 'cwd': '/', 'env': ['PATH=/bin']},
+        ]
+        batch_file = os.path.join(temp_dir, "batch.json")
+        with open(batch_file, "w") as f:
+            json.dump(batch, f)
+        out = run_crun_command(["exec", "--batch", batch_file, cid])
+
+        nofile = [line.split()[3:5] for line in out.splitlines() if line.startswith("Max open files")]
+        if len(nofile) != 2 or nofile.count(['100', '200']) != 1:
+            sys.stderr.write("# wrong RLIMIT_NOFILE for the batch: %s\n" % nofile)
+            return -1
+    finally:
+        if cid is not None:
+            run_crun_command(["delete", "-f", cid])
+        shutil.rmtree(temp_dir)
+    return 0
+
 all_tests = {
     "exec" : test_exec,
     "exec-not-exists" : test_exec_not_exists,
@@ -556,6 +648,9 @@ all_tests = {
     "exec-getpgrp": test_exec_getpgrp,
     "exec-help" : test_exec_help,
     "exec-error-propagation" : test_exec_error_propagation,
+    "exec-config-digest" : test_exec_config_digest,
+    "exec-batch" : test_exec_batch,
+    "exec-batch-rlimits" : test_exec_batch_rlimits,
 }
 
 if __name__ == "__main__":
@@ -16,6 +16,7 @@
 # along with crun.  If not, see <http://www.gnu.org/licenses/>.
 
 import os
+import shutil
 from tests_utils import *
 
 def test_fail_prestart():
@@ -67,11 +68,51 @@ def test_hook_env_no_inherit():
         return -1
     return 0
 
+def test_parallel_hooks():
+    conf = base_config()
+    conf['annotations'] = {"run.oci.hooks.parallel" : "prestart"}
+
+    # Both hooks must read the full state on stdin.
+    hook = {"path" : "/bin/sh", "args" : ["/bin/sh", "-c", "grep -q '\"status\"' -"]}
+    conf['hooks'] = {"prestart" : [hook, hook]}
+    add_all_namespaces(conf)
+    try:
+        out, _ = run_and_get_output(conf)
+    except:
+        return -1
+
+    # The hooks run at the same time: each one creates its marker and
+    # waits for the marker of the other one, that would never appear if
+    # they ran one after the other.
+    temp_dir = tempfile.mkdtemp(dir=get_tests_root())
+    try:
+        def wait_for_hook(mine, other):
+            script = "touch %s; for i in $(seq 100); do test -e %s && exit 0; sleep 0.1; done; exit 1" % (
+                os.path.join(temp_dir, mine), os.path.join(temp_dir, other))
+            return {"path" : "/bin/sh", "args" : ["/bin/sh", "-c", script]}
+
+        conf['hooks'] = {"prestart" : [wait_for_hook("a", "b"), wait_for_hook("b", "a")]}
+        try:
+            out, _ = run_and_get_output(conf)
+        except:
+            sys.stderr.write("# the hooks did not run in parallel\n")
+            return -1
+    finally:
+        shutil.rmtree(temp_dir)
+
+    conf['hooks'] = {"prestart" : [hook, {"path" : "/bin/false"}]}
+    try:
+        out, _ = run_and_get_output(conf)
+    except:
+        return 0
+    return -1
+
 all_tests = {
     "test-fail-prestart" : test_fail_prestart,
     "test-success-prestart" : test_success_prestart,
     "test-hook-env-inherit" : test_hook_env_inherit,
     "test-hook-env-no-inherit" : test_hook_env_no_inherit,
+    "test-parallel-hooks" : test_parallel_hooks,
 }
 
 if __name__ == "__main__":
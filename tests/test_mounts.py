@@ -131,6 +131,30 @@ def test_mount_tmpfs_permissions():
     sys.stderr.write("# actual output: %s\n" % out)
     return -1
 
+def test_mount_tmpfs_options():
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'cat', '/proc/self/mountinfo']
+    add_all_namespaces(conf)
+    conf['mounts'].append({"destination": "/var/dir", "type": "tmpfs", "source": "tmpfs",
+                           "options": ["nosuid", "noexec", "rprivate", "mode=1770", "size=1m"]})
+    out, _ = run_and_get_output(conf, hide_stderr=True)
+    with tempfile.NamedTemporaryFile(mode='w', delete=True) as f:
+        f.write(out)
+        f.flush()
+        m = libmount.Table(f.name).find_target('/var/dir')
+    if m is None:
+        sys.stderr.write("# /var/dir not found in mountinfo: %s\n" % out)
+        return -1
+    for o in ["nosuid", "noexec"]:
+        if o not in m.vfs_options.split(","):
+            sys.stderr.write("# option %s not found in %s\n" % (o, m.vfs_options))
+            return -1
+    for o in ["mode=1770", "size=1024k"]:
+        if o not in m.fs_options.split(","):
+            sys.stderr.write("# option %s not found in %s\n" % (o, m.fs_options))
+            return -1
+    return 0
+
 def test_mount_bind_to_rootfs():
     conf = base_config()
     conf['process']['args'] = ['/init', 'true']
@@ -917,6 +941,7 @@ all_tests = {
     "mount-bind-mount-symlink-nofollow": test_bind_mount_symlink_nofollow,
     "mount-bind-mount-file-nofollow": test_bind_mount_file_nofollow,
     "mount-tmpfs-permissions": test_mount_tmpfs_permissions,
+    "mount-tmpfs-options": test_mount_tmpfs_options,
     "mount-add-remove-mounts": test_add_remove_mounts,
     "mount-help": test_mount_help,
 }
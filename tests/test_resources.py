@@ -15,6 +15,7 @@
 # You should have received a copy of the GNU General Public License
 # along with crun.  If not, see <http://www.gnu.org/licenses/>.
 
+import json
 import subprocess
 import sys
 import time
@@ -342,6 +343,34 @@ def test_resources_exec_cgroup():
     return 0
 
 
+def test_resources_events_stats():
+    if not is_cgroup_v2_unified() or is_rootless():
+        return 77
+
+    conf = base_config()
+    add_all_namespaces(conf)
+    conf['process']['args'] = ['/init', 'pause']
+    cid = None
+    try:
+        _, cid = run_and_get_output(conf, command='run', detach=True)
+        out = run_crun_command(["events", "--stats", cid])
+        event = json.loads(out.split("\n")[0])
+        if event['type'] != 'stats' or event['id'] != cid:
+            sys.stderr.write("# invalid event %s\n" % out)
+            return -1
+        if event['data'].get('pids.current', 0) < 1:
+            sys.stderr.write("# pids.current not found in %s\n" % out)
+            return -1
+        return 0
+    except Exception as e:
+        sys.stderr.write("# test failed with %s\n" % e)
+        return -1
+    finally:
+        if cid is not None:
+            run_crun_command(["delete", "-f", cid])
+    return 0
+
+
 all_tests = {
     "resources-v2-swap-disabled": test_resources_cgroupv2_swap_0,
     "resources-pid-limit" : test_resources_pid_limit,
@@ -354,6 +383,7 @@ all_tests = {
     "resources-cpu-weight" : test_resources_cpu_weight,
     "resources-cpu-weight-systemd" : test_resources_cpu_weight_systemd,
     "resources-cpu-quota-minus-one" : test_resources_cpu_quota_minus_one,
+    "resources-events-stats" : test_resources_events_stats,
 }
 
 if __name__ == "__main__":
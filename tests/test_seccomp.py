@@ -21,6 +21,9 @@ import os
 import socket
 import sys
 import array
+import shutil
+import tempfile
+import struct
 from tests_utils import *
 
 def is_seccomp_listener_supported():
@@ -110,8 +113,79 @@ def test_seccomp_listener():
         except Exception as cleanup_e:
             sys.stderr.write("# warning: failed to cleanup listener socket %s: %s\n" % (listener_path, str(cleanup_e)))
 
+# Each record in the shard index is the checksum followed by the time it
+# was last used, see struct seccomp_cache_record.
+SECCOMP_CACHE_RECORD = struct.Struct("=64sQ")
+
+def get_seccomp_cache_last_used(shard, checksum):
+    with open(os.path.join(shard, "index"), "rb") as f:
+        data = f.read()
+    for off in range(0, len(data) - SECCOMP_CACHE_RECORD.size + 1, SECCOMP_CACHE_RECORD.size):
+        record, last_used = SECCOMP_CACHE_RECORD.unpack_from(data, off)
+        if record.decode() == checksum:
+            return last_used
+    return None
+
+def test_seccomp_compile():
+    conf = base_config()
+    add_all_namespaces(conf)
+    conf['linux']['seccomp'] = {
+        'defaultAction': 'SCMP_ACT_ALLOW',
+        'syscalls': [{'names': ['mkdir'], 'action': 'SCMP_ACT_ERRNO'}],
+    }
+    conf['process']['args'] = ['/init', 'true']
+
+    temp_dir = tempfile.mkdtemp(dir=get_tests_root())
+    try:
+        config_path = os.path.join(temp_dir, "config.json")
+        with open(config_path, "w") as f:
+            json.dump(conf, f)
+
+        checksum = run_crun_command(["seccomp-compile", config_path]).strip()
+        if len(checksum) != 64:
+            sys.stderr.write("# invalid checksum %s\n" % checksum)
+            return -1
+
+        shard = os.path.join(get_tests_root_status(), ".cache", "seccomp", checksum[0])
+        if not os.path.exists(os.path.join(shard, checksum)):
+            sys.stderr.write("# the filter is not in the cache\n")
+            return -1
+
+        # Compiling it again finds it in the cache.
+        if run_crun_command(["seccomp-compile", config_path]).strip() != checksum:
+            sys.stderr.write("# the checksum changed\n")
+            return -1
+
+        entry = os.path.join(shard, checksum)
+        last_used = get_seccomp_cache_last_used(shard, checksum)
+        if last_used is None:
+            sys.stderr.write("# the filter is not in the cache index\n")
+            return -1
+
+        # The container uses the cached filter: its seccomp.bpf is a hard
+        # link to the cache entry and the hit is recorded in the index.
+        _, cid = run_and_get_output(conf, command='create')
+        try:
+            bpf = os.path.join(get_tests_root_status(), cid, "seccomp.bpf")
+            if not os.path.samefile(bpf, entry):
+                sys.stderr.write("# the container does not use the cached filter\n")
+                return -1
+        finally:
+            run_crun_command(["delete", "-f", cid])
+
+        if get_seccomp_cache_last_used(shard, checksum) <= last_used:
+            sys.stderr.write("# the cache hit was not recorded in the index\n")
+            return -1
+    except Exception as e:
+        sys.stderr.write("# seccomp-compile test failed with exception: %s\n" % str(e))
+        return -1
+    finally:
+        shutil.rmtree(temp_dir)
+    return 0
+
 all_tests = {
     "seccomp-listener" : test_seccomp_listener,
+    "seccomp-compile" : test_seccomp_compile,
 }
 
 if __name__ == "__main__":
@@ -0,0 +1,215 @@
+#!/bin/env python3
+# crun - OCI runtime written in C
+#
+# Copyright (C) 2017, 2018, 2019 Giuseppe Scrivano <giuseppe@scrivano.org>
+# crun is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# crun is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with crun.  If not, see <http://www.gnu.org/licenses/>.
+
+import json
+import socket
+import stat
+from tests_utils import *
+
+def make_bundle(conf):
+    bundle = tempfile.mkdtemp(dir=get_tests_root())
+    rootfs = os.path.join(bundle, "rootfs")
+    for i in ["proc", "sys", "dev", "etc"]:
+        os.makedirs(os.path.join(rootfs, i))
+    shutil.copy2(get_init_path(), os.path.join(rootfs, "init"))
+    with open(os.path.join(bundle, "config.json"), "w") as f:
+        json.dump(conf, f)
+    return bundle
+
+def start_server(socket_path, args=None):
+    cmd = [get_crun_path(), "--cgroup-manager", "cgroupfs", "--root", get_tests_root_status(), "serve"] + (args or []) + [socket_path]
+    server = subprocess.Popen(cmd, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+    for i in range(100):
+        if os.path.exists(socket_path):
+            return server
+        if server.poll() is not None:
+            break
+        time.sleep(0.05)
+    server.kill()
+    server.wait()
+    raise Exception("serve did not create the socket: %s" % server.stderr.read().decode('utf-8', errors='ignore'))
+
+def stop_server(server):
+    server.terminate()
+    server.wait()
+
+def request(socket_path, req):
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as s:
+        s.connect(socket_path)
+        s.sendall((json.dumps(req) + "\n").encode())
+        s.shutdown(socket.SHUT_WR)
+        data = b""
+        while True:
+            chunk = s.recv(4096)
+            if not chunk:
+                break
+            data += chunk
+    return json.loads(data.decode())
+
+def check_error(socket_path, req, message):
+    reply = request(socket_path, req)
+    if reply.get('status', 0) >= 0 or message not in reply.get('error', ''):
+        sys.stderr.write("# unexpected reply to %s: %s\n" % (json.dumps(req), reply))
+        return False
+    return True
+
+def serve_lifecycle(server_args):
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'pause']
+    add_all_namespaces(conf)
+
+    bundle = make_bundle(conf)
+    socket_path = os.path.join(get_tests_root(), "serve.sock")
+    cid = "test-serve-%d" % os.getpid()
+    server = start_server(socket_path, server_args)
+    try:
+        reply = request(socket_path, {"command": "create", "id": cid, "bundle": bundle})
+        if reply['status'] != 0:
+            sys.stderr.write("# create failed: %s\n" % reply)
+            return -1
+
+        state = request(socket_path, {"command": "state", "id": cid})
+        if state.get('id') != cid or state.get('status') != "created":
+            sys.stderr.write("# wrong state after create: %s\n" % state)
+            return -1
+
+        reply = request(socket_path, {"command": "start", "id": cid})
+        if reply['status'] != 0:
+            sys.stderr.write("# start failed: %s\n" % reply)
+            return -1
+
+        state = request(socket_path, {"command": "state", "id": cid})
+        if state.get('status') != "running":
+            sys.stderr.write("# wrong state after start: %s\n" % state)
+            return -1
+
+        # The container is visible to the crun CLI too.
+        state = json.loads(run_crun_command(["state", cid]))
+        if state['status'] != "running":
+            return -1
+
+        reply = request(socket_path, {"command": "kill", "id": cid, "signal": "KILL"})
+        if reply['status'] != 0:
+            sys.stderr.write("# kill failed: %s\n" % reply)
+            return -1
+
+        for i in range(50):
+            state = request(socket_path, {"command": "state", "id": cid})
+            if state.get('status') == "stopped":
+                break
+            time.sleep(0.1)
+        else:
+            sys.stderr.write("# container not stopped after kill: %s\n" % state)
+            return -1
+
+        reply = request(socket_path, {"command": "delete", "id": cid})
+        if reply['status'] != 0:
+            sys.stderr.write("# delete failed: %s\n" % reply)
+            return -1
+
+        if not check_error(socket_path, {"command": "state", "id": cid}, cid):
+            return -1
+    finally:
+        subprocess.call([get_crun_path(), "--root", get_tests_root_status(), "delete", "-f", cid],
+                        stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        stop_server(server)
+    return 0
+
+def test_serve_lifecycle():
+    return serve_lifecycle([])
+
+def test_serve_pool():
+    if serve_lifecycle(["--pool-size", "2"]) != 0:
+        return -1
+
+    # More requests than workers, each worker serves one request and is
+    # replaced.
+    socket_path = os.path.join(get_tests_root(), "serve.sock")
+    server = start_server(socket_path, ["--pool-size", "2"])
+    try:
+        for i in range(10):
+            if not check_error(socket_path, {"command": "state", "id": "does-not-exist-%d" % i}, "does-not-exist-%d" % i):
+                return -1
+        if server.poll() is not None:
+            return -1
+    finally:
+        stop_server(server)
+    return 0
+
+def test_serve_errors():
+    socket_path = os.path.join(get_tests_root(), "serve.sock")
+    server = start_server(socket_path)
+    try:
+        if not check_error(socket_path, {"command": "start"}, "must be specified"):
+            return -1
+        if not check_error(socket_path, {"command": "frobnicate", "id": "foo"}, "unknown command"):
+            return -1
+        if not check_error(socket_path, {"command": "create", "id": "foo", "bundle": "relative"}, "absolute path"):
+            return -1
+        if not check_error(socket_path, {"command": "start", "id": "does-not-exist"}, "does-not-exist"):
+            return -1
+
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as s:
+            s.connect(socket_path)
+            s.sendall(b"{not json\n")
+            reply = json.loads(s.makefile().readline())
+            if reply['status'] >= 0 or "cannot parse request" not in reply['error']:
+                sys.stderr.write("# unexpected reply to a malformed request: %s\n" % reply)
+                return -1
+
+        # The server is still serving after the failed requests.
+        if not check_error(socket_path, {"command": "kill", "id": "does-not-exist"}, "does-not-exist"):
+            return -1
+    finally:
+        stop_server(server)
+    return 0
+
+def test_serve_socket():
+    socket_path = os.path.join(get_tests_root(), "serve.sock")
+
+    server = start_server(socket_path, ["--socket-mode", "0660"])
+    stop_server(server)
+    mode = stat.S_IMODE(os.lstat(socket_path).st_mode)
+    if mode != 0o660:
+        sys.stderr.write("# wrong socket mode %o\n" % mode)
+        return -1
+
+    # A stale socket is replaced.
+    server = start_server(socket_path)
+    stop_server(server)
+
+    # Any other file is left untouched.
+    not_a_socket = os.path.join(get_tests_root(), "not-a-socket")
+    with open(not_a_socket, "w") as f:
+        f.write("data")
+    cmd = [get_crun_path(), "--root", get_tests_root_status(), "serve", not_a_socket]
+    if subprocess.call(cmd, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL) == 0:
+        return -1
+    with open(not_a_socket) as f:
+        if f.read() != "data":
+            return -1
+    return 0
+
+all_tests = {
+    "serve-lifecycle" : test_serve_lifecycle,
+    "serve-pool" : test_serve_pool,
+    "serve-errors" : test_serve_errors,
+    "serve-socket" : test_serve_socket,
+}
+
+if __name__ == "__main__":
+    tests_main(all_tests)
@@ -23,6 +23,7 @@ import random
 import threading
 import socket
 import json
+import stat
 from tests_utils import *
 
 def test_not_allowed_ipc_sysctl():
@@ -529,6 +530,103 @@ def test_start_help():
     
     return 0
 
+def test_trace():
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'true']
+    conf['annotations'] = {"run.oci.trace" : "1"}
+    add_all_namespaces(conf)
+    cid = None
+    try:
+        _, cid = run_and_get_output(conf, command='create')
+        trace = os.path.join(get_tests_root_status(), cid, "trace.json")
+        mode = os.lstat(trace).st_mode
+        if not stat.S_ISREG(mode) or stat.S_IMODE(mode) != 0o600:
+            sys.stderr.write("# wrong mode for the trace file: %o\n" % mode)
+            return -1
+        with open(trace) as f:
+            events = json.load(f)
+    except Exception as e:
+        sys.stderr.write("# failed to get the trace: %s\n" % e)
+        return -1
+    finally:
+        if cid is not None:
+            run_crun_command(["delete", "-f", cid])
+
+    names = set((e['name'], e['tid']) for e in events if e['ph'] == 'B')
+    # tid 1 is crun, tid 2 is the container init.
+    for want in [("container_run", 1), ("run_linux_container", 1), ("set_mounts", 2)]:
+        if want not in names:
+            sys.stderr.write("# %s not found in the trace\n" % str(want))
+            return -1
+    return 0
+
+def test_unknown_annotation():
+    conf = base_config()
+    conf['process']['args'] = ['/init', 'true']
+    conf['annotations'] = {"run.oci.no_such_annotation" : "1", "run.oci.terminal_buffer_size" : "foo"}
+    add_all_namespaces(conf)
+    out, _ = run_and_get_output(conf)
+    for want in ["unknown annotation `run.oci.no_such_annotation`", "invalid value for `run.oci.terminal_buffer_size`"]:
+        if want not in out:
+            sys.stderr.write("# warning `%s` not found in the output: %s\n" % (want, out))
+            return -1
+    return 0
+
+def systemctl_show(prop, unit):
+    args = ['systemctl', 'show', '-P' + prop, unit]
+    if is_rootless():
+        args.insert(1, '--user')
+    return subprocess.check_output(args, close_fds=False).decode().strip()
+
+def test_systemd_scope_before_start():
+    if 'SYSTEMD' not in get_crun_feature_string():
+        return 77
+    if not running_on_systemd() or not is_cgroup_v2_unified():
+        return 77
+
+    conf = base_config()
+    add_all_namespaces(conf)
+    conf['process']['args'] = ['/init', 'cat', '/proc/self/cgroup']
+    scope = 'crun-%d.scope' % random.randint(10000, 99999)
+    conf['linux']['cgroupsPath'] = ':crun:%s' % scope[len('crun-'):-len('.scope')]
+
+    # The scope is created asynchronously, the container process must be
+    # released only once it is in the scope.
+    out, _ = run_and_get_output(conf, cgroup_manager="systemd")
+    if scope not in out:
+        sys.stderr.write("# the process is not in %s: %s\n" % (scope, out))
+        return -1
+    return 0
+
+def test_systemd_scope_destroyed_on_failure():
+    if 'SYSTEMD' not in get_crun_feature_string():
+        return 77
+    if not running_on_systemd() or not is_cgroup_v2_unified():
+        return 77
+
+    conf = base_config()
+    add_all_namespaces(conf)
+    conf['process']['args'] = ['/init', 'true']
+    scope = 'crun-%d.scope' % random.randint(10000, 99999)
+    conf['linux']['cgroupsPath'] = ':crun:%s' % scope[len('crun-'):-len('.scope')]
+    # Accepted by systemd, rejected once the scope is joined.
+    conf['linux']['resources'] = {'unified': {'invalid/key': '1'}}
+
+    try:
+        run_and_get_output(conf, cgroup_manager="systemd")
+        sys.stderr.write("# unexpected success\n")
+        return -1
+    except subprocess.CalledProcessError as e:
+        if "without any slash" not in e.output.decode('utf-8', errors='ignore'):
+            return -1
+
+    for i in range(50):
+        if systemctl_show('ActiveState', scope) not in ['active', 'activating', 'deactivating']:
+            return 0
+        time.sleep(0.1)
+    sys.stderr.write("# %s left behind\n" % scope)
+    return -1
+
 # https://github.com/containers/crun/issues/1811.
 def test_systemd_cgroups_path_def_slice():
     if 'SYSTEMD' not in get_crun_feature_string():
@@ -589,6 +687,10 @@ all_tests = {
     "home-unknown-id": test_home_unknown_id,
     "help": test_start_help,
     "systemd-cgroups-path-def-slice": test_systemd_cgroups_path_def_slice,
+    "systemd-scope-before-start": test_systemd_scope_before_start,
+    "systemd-scope-destroyed-on-failure": test_systemd_scope_destroyed_on_failure,
+    "trace": test_trace,
+    "unknown-annotation": test_unknown_annotation,
 }
 
 if __name__ == "__main__":
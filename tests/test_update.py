@@ -49,6 +49,56 @@ def test_update():
         shutil.rmtree(temp_dir)
     return 1
 
+def update_many(cgroup_manager):
+    if not is_cgroup_v2_unified() or is_rootless():
+        return 77
+
+    conf = base_config()
+    add_all_namespaces(conf, cgroupns=True)
+    conf['process']['args'] = ['/init', 'pause']
+
+    ids = []
+    try:
+        for i in range(3):
+            _, cid = run_and_get_output(conf, command='run', detach=True, cgroup_manager=cgroup_manager)
+            ids.append(cid)
+
+        run_crun_command(["update", "--pids-limit", "123"] + ids)
+
+        for cid in ids:
+            out = run_crun_command(["exec", cid, "/init", "cat", "/sys/fs/cgroup/pids.max"])
+            if "123" not in out:
+                sys.stderr.write("# wrong pids.max %s for %s\n" % (out, cid))
+                return -1
+
+        # If any of the containers does not exist, none is updated.
+        try:
+            run_crun_command(["update", "--pids-limit", "456"] + ids + ["does-not-exist"])
+            sys.stderr.write("# update with a missing container did not fail\n")
+            return -1
+        except subprocess.CalledProcessError:
+            pass
+
+        for cid in ids:
+            out = run_crun_command(["exec", cid, "/init", "cat", "/sys/fs/cgroup/pids.max"])
+            if "123" not in out:
+                sys.stderr.write("# pids.max changed to %s for %s\n" % (out, cid))
+                return -1
+    finally:
+        for cid in ids:
+            run_crun_command(["delete", "-f", cid])
+    return 0
+
+def test_update_many():
+    return update_many("cgroupfs")
+
+def test_update_many_systemd():
+    if 'SYSTEMD' not in get_crun_feature_string():
+        return 77
+    if not running_on_systemd():
+        return 77
+    return update_many("systemd")
+
 def test_update_help():
     out = run_crun_command(["update", "--help"])
     if "Usage: crun [OPTION...] update [OPTION]... CONTAINER" not in out:
@@ -58,6 +108,8 @@ def test_update_help():
 
 all_tests = {
     "test-update" : test_update,
+    "test-update-many" : test_update_many,
+    "test-update-many-systemd" : test_update_many_systemd,
     "test-update-help": test_update_help,
 }
 
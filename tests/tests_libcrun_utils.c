@@ -16,12 +16,15 @@
  * along with crun.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
+
 #include <libcrun/error.h>
 #include <libcrun/utils.h>
 #include <libcrun/cgroup.h>
 #include <libcrun/cgroup-systemd.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <string.h>
 
 typedef int (*test) ();
@@ -70,6 +73,48 @@ test_socket_pair ()
   return 0;
 }
 
+static int
+test_channel_fd_pair ()
+{
+  libcrun_error_t err = NULL;
+  cleanup_channel_fd_pair struct channel_fd_pair *channel = NULL;
+  cleanup_close int in_r = -1;
+  cleanup_close int in_w = -1;
+  cleanup_close int out_r = -1;
+  cleanup_close int out_w = -1;
+  int in_fds[2], out_fds[2];
+  char buffer[256];
+  int ret;
+
+  if (pipe2 (in_fds, O_NONBLOCK) < 0 || pipe2 (out_fds, O_NONBLOCK) < 0)
+    return -1;
+  in_r = in_fds[0];
+  in_w = in_fds[1];
+  out_r = out_fds[0];
+  out_w = out_fds[1];
+
+  channel = channel_fd_pair_new (in_r, out_w, 4096);
+
+  ret = write (in_w, "HELLO", 6);
+  if (ret != 6)
+    return -1;
+
+  ret = channel_fd_pair_process (channel, &err);
+  if (ret < 0)
+    {
+      crun_error_release (&err);
+      return -1;
+    }
+
+  ret = read (out_r, buffer, sizeof (buffer));
+  if (ret != 6)
+    return -1;
+  if (strcmp (buffer, "HELLO") != 0)
+    return -1;
+
+  return 0;
+}
+
 static int
 test_send_receive_fd ()
 {
@@ -237,6 +282,86 @@ test_write_read_file ()
   return failed ? -1 : 0;
 }
 
+static int
+test_copy_from_fd_to_fd ()
+{
+  libcrun_error_t err = NULL;
+  cleanup_free char *src_name = NULL;
+  cleanup_free char *dst_name = NULL;
+  cleanup_free char *read_buf = NULL;
+  size_t max = 1 << 20;
+  cleanup_free char *written = xmalloc (max);
+  int src = -1, dst = -1, pipes[2] = { -1, -1 };
+  size_t i, len;
+  int ret, failed = 1;
+
+  xasprintf (&src_name, "tests/copy-src-%i", getpid ());
+  xasprintf (&dst_name, "tests/copy-dst-%i", getpid ());
+
+  for (i = 0; i < max; i++)
+    written[i] = i * 7;
+
+  ret = write_file (src_name, written, max, &err);
+  if (ret < 0)
+    goto exit;
+
+  /* A regular file, larger than a single chunk.  */
+  src = open (src_name, O_RDONLY | O_CLOEXEC);
+  dst = open (dst_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (src < 0 || dst < 0)
+    goto exit;
+
+  ret = copy_from_fd_to_fd (src, dst, 1, &err);
+  if (ret < 0)
+    goto exit;
+  close (dst);
+  dst = -1;
+
+  ret = read_all_file (dst_name, &read_buf, &len, &err);
+  if (ret < 0 || len != max || memcmp (read_buf, written, len) != 0)
+    goto exit;
+  free (read_buf);
+  read_buf = NULL;
+
+  /* A pipe, that copy_file_range does not support.  */
+  if (pipe (pipes) < 0)
+    goto exit;
+  ret = write (pipes[1], written, 4096);
+  close (pipes[1]);
+  pipes[1] = -1;
+  if (ret != 4096)
+    goto exit;
+
+  dst = open (dst_name, O_WRONLY | O_TRUNC | O_CLOEXEC);
+  if (dst < 0)
+    goto exit;
+
+  ret = copy_from_fd_to_fd (pipes[0], dst, 1, &err);
+  if (ret < 0)
+    goto exit;
+
+  ret = read_all_file (dst_name, &read_buf, &len, &err);
+  if (ret < 0 || len != 4096 || memcmp (read_buf, written, len) != 0)
+    goto exit;
+
+  failed = 0;
+
+exit:
+  if (err)
+    crun_error_release (&err);
+  if (src >= 0)
+    close (src);
+  if (dst >= 0)
+    close (dst);
+  if (pipes[0] >= 0)
+    close (pipes[0]);
+  if (pipes[1] >= 0)
+    close (pipes[1]);
+  unlink (src_name);
+  unlink (dst_name);
+  return failed ? -1 : 0;
+}
+
 static int
 test_crun_path_exists ()
 {
@@ -515,15 +640,17 @@ main ()
 {
   int id = 1;
 #ifdef HAVE_SYSTEMD
-  printf ("1..11\n");
+  printf ("1..13\n");
 #else
-  printf ("1..8\n");
+  printf ("1..10\n");
 #endif
   RUN_TEST (test_crun_path_exists);
   RUN_TEST (test_write_read_file);
+  RUN_TEST (test_copy_from_fd_to_fd);
   RUN_TEST (test_run_process);
   RUN_TEST (test_dir_p);
   RUN_TEST (test_socket_pair);
+  RUN_TEST (test_channel_fd_pair);
   RUN_TEST (test_send_receive_fd);
   RUN_TEST (test_append_paths);
   RUN_TEST (test_path_is_slash_dev);